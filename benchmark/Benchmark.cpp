@@ -0,0 +1,80 @@
+#include "Benchmark.h"
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <dirent.h>
+#endif
+
+namespace Benchmark
+{
+	std::vector<std::string> ListFiles(std::string p_directory)
+	{
+		std::vector<std::string> files;
+#ifdef _WIN32
+		WIN32_FIND_DATAA data;
+		HANDLE find = FindFirstFileA((p_directory + "\\*").c_str(), &data);
+		if (find != INVALID_HANDLE_VALUE)
+		{
+			do
+			{
+				if ((data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) == 0)
+				{
+					files.push_back(p_directory + "\\" + data.cFileName);
+				}
+			}
+			while (FindNextFileA(find, &data));
+			FindClose(find);
+		}
+#else
+		DIR* directory = opendir(p_directory.c_str());
+		if (directory != NULL)
+		{
+			dirent* entry;
+			while ((entry = readdir(directory)) != NULL)
+			{
+				if (entry->d_name[0] != '.')
+				{
+					files.push_back(p_directory + "/" + entry->d_name);
+				}
+			}
+			closedir(directory);
+		}
+#endif
+		std::sort(files.begin(), files.end());
+		return files;
+	}
+
+	double TicksToMilliseconds(int64 p_ticks)
+	{
+		return ((p_ticks * 1000.0) / cv::getTickFrequency());
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	std::string benchmark = (argc > 1) ? argv[1] : "";
+
+	if (benchmark == "undistort" && argc > 2)
+	{
+		std::string calibrationFile = (argc > 3) ? argv[3] : "resources/camera_calibration_out.xml";
+		return Benchmark::RunUndistortBenchmark(argv[2], calibrationFile);
+	}
+
+	if (benchmark == "classify" && argc > 2)
+	{
+		return Benchmark::RunClassifyBenchmark(argv[2]);
+	}
+
+	if (benchmark == "capture" && argc > 2)
+	{
+		return Benchmark::RunCaptureBenchmark(argv[2]);
+	}
+
+	std::cout << "Usage:" << std::endl;
+	std::cout << "  KB06Benchmark undistort <video> [calibration.xml]" << std::endl;
+	std::cout << "  KB06Benchmark classify <video>" << std::endl;
+	std::cout << "  KB06Benchmark capture <directory>" << std::endl;
+	return 1;
+}
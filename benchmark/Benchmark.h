@@ -0,0 +1,57 @@
+#ifndef __BENCHMARK__BENCHMARK__H__
+#define __BENCHMARK__BENCHMARK__H__
+
+#include <opencv/cv.h>
+#include <opencv/highgui.h>
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/**
+ * @brief	The Benchmark namespace contains headless performance measurements of the capture path.
+ *			Every benchmark runs over recorded footage, so no camera or window is needed.
+ * @author	Bas Stroosnijder
+ */
+namespace Benchmark
+{
+	/**
+	 * @brief	Compares cv::undistort with the cached remap tables of CalibrationParams
+	 * @param	p_videoFile The recorded video to undistort
+	 * @param	p_calibrationFile The calibration parameters to undistort with
+	 * @return	The exit code of the benchmark
+	 */
+	int RunUndistortBenchmark(std::string p_videoFile, std::string p_calibrationFile);
+
+	/**
+	 * @brief	Compares cv::cvtColor with cv::inRange against the ColorClassifier and checks the masks are identical
+	 * @param	p_videoFile The recorded video to classify
+	 * @return	The exit code of the benchmark, 1 when a mask differs
+	 */
+	int RunClassifyBenchmark(std::string p_videoFile);
+
+	/**
+	 * @brief	Runs the whole detection path of the capture and the pencil detection over every video in a directory.
+	 *			A video may have ground truth next to it with the same name and a .yml extension, holding
+	 *			select_x and select_y (a point on the board to choose) and pencils (the number of pencils on the board).
+	 * @param	p_directory The directory with the recorded videos
+	 * @return	The exit code of the benchmark, 1 when no video could be read
+	 */
+	int RunCaptureBenchmark(std::string p_directory);
+
+	/**
+	 * @brief	Lists the files in a directory
+	 * @param	p_directory The directory to list
+	 * @return	The paths of the files, sorted by name
+	 */
+	std::vector<std::string> ListFiles(std::string p_directory);
+
+	/**
+	 * @brief	Converts a tick count to milliseconds
+	 * @param	p_ticks The number of ticks from cv::getTickCount
+	 * @return	The number of milliseconds
+	 */
+	double TicksToMilliseconds(int64 p_ticks);
+}
+
+#endif
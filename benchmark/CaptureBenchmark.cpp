@@ -0,0 +1,184 @@
+#include "Benchmark.h"
+#include "Camera/Capture.h"
+#include "Camera/VideoSource.h"
+#include "Utility/Profiler.h"
+#include <cstdlib>
+
+namespace Benchmark
+{
+	/**
+	 * @brief	Whether a file is a video the benchmark can replay
+	 */
+	static bool IsVideoFile(const std::string& p_fileName)
+	{
+		const char* extensions[] = { ".avi", ".mp4", ".mkv", ".mov", ".wmv" };
+		for (int i = 0; i < 5; ++i)
+		{
+			std::string extension = extensions[i];
+			if (p_fileName.size() > extension.size() &&
+					p_fileName.compare(p_fileName.size() - extension.size(), extension.size(), extension) == 0)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	int RunCaptureBenchmark(std::string p_directory)
+	{
+		std::vector<std::string> files = ListFiles(p_directory);
+		Utility::Profiler* profiler = Utility::Profiler::GetInstance();
+		profiler->SetEnabled(true);
+
+		int videos = 0;
+		long long totalFrames = 0;
+		long long totalLocked = 0;
+		long long totalAnnotated = 0;
+		long long totalExact = 0;
+		long long totalPencilError = 0;
+		int64 totalTicks = 0;
+
+		for (unsigned int file = 0; file < files.size(); ++file)
+		{
+			if (!IsVideoFile(files[file]))
+			{
+				continue;
+			}
+
+			Camera::VideoSource* source = new Camera::VideoSource(files[file]);
+			if (!source->IsOpened())
+			{
+				std::cout << "Could not open " << files[file] << std::endl;
+				delete source;
+				continue;
+			}
+			// Every frame is read once and as fast as possible
+			source->SetLoop(false);
+			source->SetPaced(false);
+			cv::Size size = source->GetSize();
+
+			// Without ground truth the board is chosen in the center and pencils are only counted
+			cv::Point2f selection = cv::Point2f((size.width - 1) / 2.0f, (size.height - 1) / 2.0f);
+			int expectedPencils = -1;
+			std::string annotationFile = files[file].substr(0, files[file].find_last_of('.')) + ".yml";
+			cv::FileStorage annotation = cv::FileStorage(annotationFile, cv::FileStorage::READ);
+			if (annotation.isOpened())
+			{
+				if (!annotation["select_x"].empty() && !annotation["select_y"].empty())
+				{
+					selection = cv::Point2f(static_cast<float>(annotation["select_x"]), static_cast<float>(annotation["select_y"]));
+				}
+				if (!annotation["pencils"].empty())
+				{
+					expectedPencils = static_cast<int>(annotation["pencils"]);
+				}
+				annotation.release();
+			}
+
+			// No texture and no own thread; every stage runs once per Start, like the single threaded game
+			Camera::Capture* capture = new Camera::Capture(false, irr::core::dimension2du(size.width, size.height), NULL, NULL, source);
+			capture->SetAsyncAcquisition(false);
+			capture->SetDebugOutput(false);
+			capture->SetShortestGameLine(irr::core::line2df(
+					irr::core::vector2df(0.0f, 0.0f),
+					irr::core::vector2df(0.0f, 1000.0f)));
+			capture->Select(selection);
+
+			irr::core::matrix4 projection;
+			projection.buildProjectionMatrixPerspectiveFovLH((60.0f * irr::core::DEGTORAD),
+					(static_cast<float>(size.width) / size.height), 1.0f, 50000.0f);
+
+			profiler->ResetHistograms();
+			long long frames = 0;
+			long long locked = 0;
+			long long annotated = 0;
+			long long exact = 0;
+			long long pencilError = 0;
+			long long pencilSum = 0;
+
+			int64 start = cv::getTickCount();
+			while (true)
+			{
+				capture->Start();
+				if (!capture->AcquireFrame())
+				{
+					// The recording ran out of frames
+					break;
+				}
+				++frames;
+
+				if (!capture->IsLost())
+				{
+					++locked;
+
+					irr::core::vector3df* startPoints = NULL;
+					irr::core::vector3df* endPoints = NULL;
+					int pencils = capture->FindStartAndEndPoints(capture->GetImage(), projection, startPoints, endPoints);
+					delete[] startPoints;
+					delete[] endPoints;
+
+					pencilSum += pencils;
+					if (expectedPencils >= 0)
+					{
+						++annotated;
+						pencilError += std::abs(pencils - expectedPencils);
+						if (pencils == expectedPencils)
+						{
+							++exact;
+						}
+					}
+				}
+			}
+			int64 ticks = (cv::getTickCount() - start);
+			delete capture;
+
+			if (frames == 0)
+			{
+				std::cout << "No frames in " << files[file] << std::endl;
+				continue;
+			}
+
+			double seconds = (TicksToMilliseconds(ticks) / 1000.0);
+			std::cout << files[file] << std::endl;
+			std::cout << "  Frames:                " << frames << ", " << (frames / seconds) << " fps" << std::endl;
+			std::cout << "  Board lock:            " << ((locked * 100.0) / frames) << "%" << std::endl;
+			std::cout << "  Pencils per frame:     " << ((locked > 0) ? (static_cast<double>(pencilSum) / locked) : 0.0);
+			if (expectedPencils >= 0)
+			{
+				std::cout << ", expected " << expectedPencils;
+				if (annotated > 0)
+				{
+					std::cout << ", " << ((exact * 100.0) / annotated) << "% exact, mean error "
+							<< (static_cast<double>(pencilError) / annotated);
+				}
+			}
+			std::cout << std::endl;
+			std::cout << profiler->GetSummary() << std::endl;
+
+			++videos;
+			totalFrames += frames;
+			totalLocked += locked;
+			totalAnnotated += annotated;
+			totalExact += exact;
+			totalPencilError += pencilError;
+			totalTicks += ticks;
+		}
+
+		if (videos == 0)
+		{
+			std::cout << "No videos in " << p_directory << std::endl;
+			return 1;
+		}
+
+		std::cout << "Videos:                  " << videos << std::endl;
+		std::cout << "Frames:                  " << totalFrames << ", "
+				<< (totalFrames / (TicksToMilliseconds(totalTicks) / 1000.0)) << " fps" << std::endl;
+		std::cout << "Board lock:              " << ((totalLocked * 100.0) / totalFrames) << "%" << std::endl;
+		if (totalAnnotated > 0)
+		{
+			std::cout << "Pencils exact:           " << ((totalExact * 100.0) / totalAnnotated) << "%, mean error "
+					<< (static_cast<double>(totalPencilError) / totalAnnotated) << std::endl;
+		}
+		return 0;
+	}
+}
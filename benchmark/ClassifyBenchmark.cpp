@@ -0,0 +1,83 @@
+#include "Benchmark.h"
+#include "Camera/ColorClassifier.h"
+
+namespace Benchmark
+{
+	int RunClassifyBenchmark(std::string p_videoFile)
+	{
+		cv::VideoCapture video = cv::VideoCapture(p_videoFile);
+		if (!video.isOpened())
+		{
+			std::cout << "Could not open " << p_videoFile << std::endl;
+			return 1;
+		}
+
+		Camera::ColorClassifier classifier;
+		cv::Mat frame;
+		cv::Mat hsv;
+		cv::Mat reference;
+		cv::Mat mask;
+		cv::Scalar lowerColor;
+		cv::Scalar upperColor;
+		int frames = 0;
+		int64 referenceTicks = 0;
+		int64 classifyTicks = 0;
+		int64 tableTicks = 0;
+		long long mismatches = 0;
+
+		while (video.read(frame))
+		{
+			if (frames == 0)
+			{
+				// Pick the color in the center of the first frame, the same way Capture does
+				cv::cvtColor(frame, hsv, CV_BGR2HSV);
+				cv::Vec3b color = hsv.at<cv::Vec3b>((frame.rows - 1) / 2, (frame.cols - 1) / 2);
+				int offset = 30;
+				lowerColor = cv::Scalar(color.val[0] - offset, color.val[1] - (offset * 3), color.val[2] - (offset * 3));
+				upperColor = cv::Scalar(color.val[0] + offset, color.val[1] + (offset * 3), color.val[2] + (offset * 3));
+
+				int64 start = cv::getTickCount();
+				classifier.SetRange(lowerColor, upperColor);
+				tableTicks = (cv::getTickCount() - start);
+			}
+
+			// The old path; a full HSV conversion followed by the range check
+			int64 start = cv::getTickCount();
+			cv::cvtColor(frame, hsv, CV_BGR2HSV);
+			cv::inRange(hsv, lowerColor, upperColor, reference);
+			referenceTicks += (cv::getTickCount() - start);
+
+			// The new path; a single lookup per pixel
+			start = cv::getTickCount();
+			classifier.Classify(frame, mask);
+			classifyTicks += (cv::getTickCount() - start);
+
+			cv::Mat difference;
+			cv::compare(reference, mask, difference, cv::CMP_NE);
+			mismatches += cv::countNonZero(difference);
+			++frames;
+		}
+
+		if (frames == 0)
+		{
+			std::cout << "No frames in " << p_videoFile << std::endl;
+			return 1;
+		}
+
+		double referenceMs = (TicksToMilliseconds(referenceTicks) / frames);
+		double classifyMs = (TicksToMilliseconds(classifyTicks) / frames);
+		double megapixels = ((static_cast<double>(frame.cols) * frame.rows) / 1000000.0);
+
+		std::cout << "Frames:                  " << frames << std::endl;
+		std::cout << "AVX2 kernel:             " << (classifier.IsUsingAvx2() ? "yes" : "no") << std::endl;
+		std::cout << "Table build:             " << TicksToMilliseconds(tableTicks) << " ms" << std::endl;
+		std::cout << "cvtColor + inRange:      " << referenceMs << " ms/frame, "
+				<< (megapixels / (referenceMs / 1000.0)) << " Mpixel/s" << std::endl;
+		std::cout << "ColorClassifier:         " << classifyMs << " ms/frame, "
+				<< (megapixels / (classifyMs / 1000.0)) << " Mpixel/s" << std::endl;
+		std::cout << "Speedup:                 " << (referenceMs / classifyMs) << "x" << std::endl;
+		std::cout << "Mismatching pixels:      " << mismatches << std::endl;
+		std::cout << "Identical masks:         " << ((mismatches == 0) ? "yes" : "no") << std::endl;
+		return ((mismatches == 0) ? 0 : 1);
+	}
+}
@@ -144,6 +144,14 @@ namespace Camera
 		 */
 		cv::Mat GetCameraMatrix();
 
+		/**
+		 * @brief	The camera matrix for frames of another size than the calibrated images.
+		 *			The focal lengths and the principal point are scaled along with the frame.
+		 * @param	p_size The size of the frames
+		 * @return	A copy of the camera matrix, scaled to p_size
+		 */
+		cv::Mat GetCameraMatrix(cv::Size p_size);
+
 		/**
 		 * @brief	The camera matrix
 		 * @param	p_cameraMatrix The camera matrix
@@ -210,6 +218,23 @@ namespace Camera
 		 */
 		void SetImagePoints(cv::Mat p_imagePoints);
 
+		/**
+		 * @brief	Undistorts an image using the camera matrix and the distortion coefficients.
+		 *			The remap tables are built once and only rebuilt when the image size,
+		 *			the camera matrix or the distortion coefficients change.
+		 * @param	p_source The distorted image, may not be the same as p_destination
+		 * @param	p_destination The undistorted image, its buffer is reused when the size matches
+		 */
+		void Undistort(const cv::Mat& p_source, cv::Mat& p_destination);
+
+		/**
+		 * @brief	Undistorts points in place, the result stays in pixel coordinates of the frame.
+		 *			Nothing happens when no calibration parameters were loaded.
+		 * @param	p_points The distorted points
+		 * @param	p_size The size of the frame the points are in
+		 */
+		void UndistortPoints(std::vector<cv::Point2f>& p_points, cv::Size p_size);
+
 	private:
 		std::string m_filename;
 		bool m_isOpenedAndGood;
@@ -227,6 +252,15 @@ namespace Camera
 		cv::Mat m_perViewReprojectionErrors;
 		cv::Mat m_extrinsicParameters;
 		cv::Mat m_imagePoints;
+		cv::Mat m_undistortMap1;
+		cv::Mat m_undistortMap2;
+		cv::Size m_undistortSize;
+
+		/**
+		 * @brief	Builds the fixed-point undistortion remap tables for the given image size
+		 * @param	p_size The size of the images that will be undistorted
+		 */
+		void UpdateUndistortMaps(cv::Size p_size);
 	};
 }
 
@@ -0,0 +1,48 @@
+#ifndef __CAMERA__CAMERASOURCE__H__
+#define __CAMERA__CAMERASOURCE__H__
+
+#include "FrameSource.h"
+#include <opencv/highgui.h>
+
+namespace Camera
+{
+	/**
+	 * @brief	Reads frames from a camera through cv::VideoCapture.
+	 *			Frames are stamped with the time they were read.
+	 *			VideoCapture cannot be asked whether a frame is waiting, so a frame is reported ready
+	 *			once most of a frame interval has passed since the last read.
+	 *			The size is switched through the capture properties, the driver decides whether it is supported.
+	 * @author	Bas Stroosnijder
+	 */
+	class CameraSource : public FrameSource
+	{
+	public:
+		/**
+		 * @brief	Constructor
+		 * @param	p_cameraId The id of the camera, CV_CAP_ANY for the first one found
+		 */
+		CameraSource(int p_cameraId);
+
+		/**
+		 * @brief	Destructor
+		 */
+		~CameraSource();
+
+		bool IsOpened();
+		cv::Size GetSize();
+		bool IsFrameReady();
+		bool SetSize(cv::Size p_size);
+		bool Read(cv::Mat& p_image);
+		double GetTimestamp();
+		void Release();
+
+	private:
+		cv::VideoCapture m_capture;
+		int64 m_startTicks;
+		int64 m_readTicks;
+		int64 m_intervalTicks;
+		double m_timestamp;
+	};
+}
+
+#endif
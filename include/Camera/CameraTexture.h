@@ -0,0 +1,77 @@
+#ifndef __CAMERA__CAMERATEXTURE__H__
+#define __CAMERA__CAMERATEXTURE__H__
+
+#include "Utility/Logger.h"
+#include <irrlicht.h>
+#include <opencv/cv.h>
+#include <algorithm>
+
+#if defined(_MSC_VER) || defined(__SSSE3__)
+#define CAMERA_TEXTURE_SSSE3
+#include <tmmintrin.h>
+#endif
+
+namespace Camera
+{
+	/**
+	 * @brief	The pair of Irrlicht textures the camera frames are shown on.
+	 *			A BGR frame is converted straight into the locked texture, so there is no BGRA copy of the frame
+	 *			in between. The conversion shuffles 16 pixels at a time with SSSE3 when the processor has it.
+	 *			Frames go into the texture that is not being drawn, which is then swapped to the front,
+	 *			so locking never has to wait for the GPU to finish drawing the previous frame.
+	 *			Only used by the render thread, the textures belong to its device.
+	 * @author	Bas Stroosnijder
+	 */
+	class CameraTexture
+	{
+	public:
+		/**
+		 * @brief	Constructor
+		 * @param	p_front The texture that is drawn first, NULL when nothing is shown
+		 * @param	p_back The texture that is written first, may be NULL to use only p_front
+		 */
+		CameraTexture(irr::video::ITexture* p_front, irr::video::ITexture* p_back);
+
+		/**
+		 * @brief	Destructor, the textures are left to the video driver
+		 */
+		~CameraTexture();
+
+		/**
+		 * @brief	Converts a frame into the back texture and brings it to the front.
+		 *			A frame larger than the texture is cut off, a smaller one leaves the rest untouched.
+		 * @param	p_image The BGR frame
+		 * @return	Whether the frame was uploaded
+		 */
+		bool Upload(const cv::Mat& p_image);
+
+		/**
+		 * @brief	The texture with the newest frame
+		 * @return	The front texture
+		 */
+		irr::video::ITexture* GetTexture();
+
+		/**
+		 * @brief	Converts one row of BGR pixels to BGRA with an opaque alpha
+		 * @param	p_source The BGR pixels
+		 * @param	p_destination Receives the BGRA pixels, may not overlap p_source
+		 * @param	p_pixels The number of pixels
+		 * @param	p_ssse3 Whether the SSSE3 shuffle may be used
+		 */
+		static void ConvertRow(const unsigned char* p_source, unsigned char* p_destination, int p_pixels, bool p_ssse3);
+
+	private:
+		irr::video::ITexture* m_textures[2];
+		int m_front;
+		bool m_ssse3;
+		bool m_formatReported;
+
+		/**
+		 * @brief	Asks the processor whether it has SSSE3
+		 * @return	Whether SSSE3 can be used
+		 */
+		static bool HasSsse3();
+	};
+}
+
+#endif
@@ -3,14 +3,33 @@
 
 #include "CalibrationParams.h"
 #include "PointDetector.h"
+#include "FrameBuffer.h"
+#include "FrameQueue.h"
+#include "FrameSource.h"
+#include "ColorClassifier.h"
+#include "ColorModel.h"
+#include "CornerTracker.h"
+#include "MotionGate.h"
+#include "PoseEstimator.h"
+#include "PosePredictor.h"
+#include "ResolutionController.h"
+#include "CameraTexture.h"
+#include "SharedFrameRing.h"
+#include "DetectionWorkspace.h"
+#include "DebugOverlay.h"
+#include "Utility/Logger.h"
+#include "Utility/ProfileScope.h"
 #include <irrlicht.h>
 #include <opencv/cv.h>
 #include <opencv/highgui.h>
 #include <thread>
 #include <mutex>
+#include <atomic>
 #include <vector>
 #include <list>
+#include <algorithm>
 #include <cmath>
+#include <sstream>
 
 namespace Camera
 {
@@ -22,13 +41,41 @@ namespace Camera
 	class Capture : public irr::IEventReceiver
 	{
 	public:
+		/**
+		 * @brief	How the camera distortion is corrected
+		 * @author	Bas Stroosnijder
+		 */
+		enum UndistortMode
+		{
+			/// Every frame is undistorted before anything is detected
+			UNDISTORT_FRAME,
+
+			/// Detection runs on the distorted frame and only the detected points are undistorted
+			UNDISTORT_POINTS
+		};
+
+		/**
+		 * @brief	How the chosen surface is separated from the rest of the frame
+		 * @author	Bas Stroosnijder
+		 */
+		enum SegmentationMode
+		{
+			/// A fixed range around the clicked color, cleaned up with a median blur and edge detection
+			SEGMENTATION_RANGE,
+
+			/// Back-projection of a learned hue-saturation model on a downscaled frame
+			SEGMENTATION_BACKPROJECTION
+		};
+
 		/**
 		 * @brief	Constructor
 		 * @param	p_runInOwnThread If the capturer should run in it's own thread
 		 * @param	p_resolution The resolution of the game screen
 		 * @param	p_texture A reference to the texture to update with the camera
+		 * @param	p_backTexture A second texture of the same size, written while p_texture is drawn; may be NULL
+		 * @param	p_frameSource The source to read frames from, the capture takes ownership of it
 		 */
-		Capture(bool p_runInOwnThread, irr::core::dimension2du p_resolution, irr::video::ITexture* p_texture);
+		Capture(bool p_runInOwnThread, irr::core::dimension2du p_resolution, irr::video::ITexture* p_texture, irr::video::ITexture* p_backTexture, FrameSource* p_frameSource);
 
 		/**
 		 * @brief	Destructor
@@ -54,12 +101,51 @@ namespace Camera
 		bool OnEvent(const irr::SEvent& P_EVT);
 
 		/**
-		 * @brief	Converts and returns the transform matrix
-		 * @param	p_cameraProjection The camera projection matrix to use for multiplications
-		 * @return	The new projection matrix
+		 * @brief	Chooses the surface under a point, the same as clicking on it
+		 * @param	p_point The point on the surface in frame coordinates
+		 */
+		void Select(cv::Point2f p_point);
+
+		/**
+		 * @brief	Sets whether the pencil detection adds its results to the DebugOverlay while it is enabled. Enabled by default.
+		 * @param	p_debugOutput Whether to show the debug output
 		 */
-		irr::core::matrix4 GetTransformMatrix(
-			irr::core::matrix4 p_cameraProjection);
+		void SetDebugOutput(bool p_debugOutput);
+
+		/**
+		 * @brief	Takes the newest frame published by the capture without waiting for it.
+		 *			All getters that describe the surface read from the acquired frame.
+		 *			Only call this from the render thread.
+		 * @return	Whether a new frame was acquired
+		 */
+		bool AcquireFrame();
+
+		/**
+		 * @brief	Gets the transform matrix of the acquired frame
+		 * @return	The transform matrix for the root scene node
+		 */
+		irr::core::matrix4 GetTransformMatrix();
+
+		/**
+		 * @brief	Gets the transform matrix of the acquired frame, moved ahead to the moment it is displayed.
+		 *			The playground keeps moving while the frame goes through the capture and the renderer,
+		 *			so the pose is extrapolated with the velocity the capture measured. At most 100 ms ahead.
+		 * @param	p_displayTicks When the rendered frame is expected on screen, in Profiler ticks
+		 * @return	The transform matrix for the root scene node
+		 */
+		irr::core::matrix4 GetPredictedTransformMatrix(long long p_displayTicks);
+
+		/**
+		 * @brief	When the camera frame of the acquired frame was read
+		 * @return	The time in Profiler ticks
+		 */
+		long long GetAcquiredTicks();
+
+		/**
+		 * @brief	The sequence number of the acquired frame
+		 * @return	The sequence number, the same as long as no newer frame was acquired
+		 */
+		unsigned long GetSequence();
 
 		/**
 		 * @brief	If the surface has been chosen
@@ -114,6 +200,8 @@ namespace Camera
 
 		/**
 		* @brief	Finds start and end points in a frame.
+		*			With motion gating the points of the last analyzed frame are handed out again
+		*			as long as nothing changed in view.
 		* @param	p_frame The frame to capture points in
 		* @param   p_startPoints A pointer to a vector3df array to store start points.
 		* @param   p_endPoints A pointer to a vector3df array to store end points.
@@ -128,27 +216,252 @@ namespace Camera
 		cv::Mat GetImage();
 
 		/**
-		 * @brief	Gets the size of the image
+		 * @brief	Gets the size of the image at the start, the texture is always this size
+		 *			even when the camera was switched to a smaller mode
 		 * @return	The size of the image
 		 */
 		irr::core::dimension2du GetCaptureSize();
 
+		/**
+		 * @brief	Gets the texture with the camera image of the acquired frame
+		 * @return	The texture to draw, NULL when the capture has no textures
+		 */
+		irr::video::ITexture* GetTexture();
+
+		/**
+		 * @brief	Sets how the camera distortion is corrected. Set this before the capture is started.
+		 * @param	p_undistortMode The new undistort mode
+		 */
+		void SetUndistortMode(UndistortMode p_undistortMode);
+
+		/**
+		 * @brief	In UNDISTORT_POINTS mode the background shows the distorted frame.
+		 *			When the interval is larger than zero every n-th frame is undistorted
+		 *			and shown instead. Set this before the capture is started.
+		 * @param	p_interval The number of frames between undistorted backgrounds, 0 to disable
+		 */
+		void SetBackgroundUndistortInterval(int p_interval);
+
+		/**
+		 * @brief	Sets whether only the area around the last known surface is searched.
+		 *			The whole frame is searched again after too many lost frames.
+		 * @param	p_roiTracking Whether to search around the last known surface
+		 */
+		void SetRoiTracking(bool p_roiTracking);
+
+		/**
+		 * @brief	Sets how far the search region reaches past the last known surface
+		 * @param	p_margin The margin in pixels
+		 */
+		void SetRoiMargin(int p_margin);
+
+		/**
+		 * @brief	Sets after how many consecutive lost frames the whole frame is searched again
+		 * @param	p_maxLostFrames The number of lost frames
+		 */
+		void SetRoiMaxLostFrames(int p_maxLostFrames);
+
+		/**
+		 * @brief	The number of frames in which the surface was found inside the search region
+		 * @return	The number of region hits
+		 */
+		unsigned long GetRoiHitCount();
+
+		/**
+		 * @brief	The number of times the capture had to fall back to searching the whole frame
+		 * @return	The number of region fallbacks
+		 */
+		unsigned long GetRoiFallbackCount();
+
+		/**
+		 * @brief	Sets whether the corners are followed with optical flow once they are detected.
+		 *			The surface is only detected again when the corners can no longer be tracked.
+		 * @param	p_cornerTracking Whether to track the corners
+		 */
+		void SetCornerTracking(bool p_cornerTracking);
+
+		/**
+		 * @brief	Sets how far a tracked corner may drift before the surface is detected again
+		 * @param	p_maxError The maximum forward-backward error in pixels
+		 * @see		CornerTracker::SetMaxError
+		 */
+		void SetCornerTrackingMaxError(float p_maxError);
+
+		/**
+		 * @brief	The number of frames in which the corners were tracked instead of detected
+		 * @return	The number of tracked frames
+		 */
+		unsigned long GetTrackedFrameCount();
+
+		/**
+		 * @brief	The number of times tracking was started from a detected surface
+		 * @return	The number of redetections
+		 */
+		unsigned long GetRedetectionCount();
+
+		/**
+		 * @brief	Sets whether every stage of the capture runs on its own thread.
+		 *			Only used when the capture runs in its own thread. Set this before the capture is started.
+		 * @param	p_pipelined Whether to run the stages on separate threads
+		 */
+		void SetPipelined(bool p_pipelined);
+
+		/**
+		 * @brief	Sets how the chosen surface is found in the frame. SEGMENTATION_BACKPROJECTION by default.
+		 * @param	p_segmentationMode The segmentation mode
+		 */
+		void SetSegmentationMode(SegmentationMode p_segmentationMode);
+
+		/**
+		 * @brief	Sets how many times smaller the frame is when the chosen surface is searched in it.
+		 *			The corners found in the smaller frame are refined in the full frame with cornerSubPix,
+		 *			so the cost of the search hardly grows with the resolution of the camera.
+		 *			Only used with SEGMENTATION_BACKPROJECTION, 4 by default.
+		 * @param	p_scale The scale, 1 searches the full frame
+		 */
+		void SetSegmentationScale(int p_scale);
+
+		/**
+		 * @brief	Sets how long the detection of a frame may take. When it takes longer for a while the surface
+		 *			is searched at a coarser scale and then the camera is switched to a smaller mode;
+		 *			when there is plenty of time left they are raised again, up to the size at the start
+		 *			and the scale of SetSegmentationScale. 25 ms by default.
+		 * @param	p_milliseconds The budget, 0 or less keeps the resolution fixed
+		 */
+		void SetProcessingBudget(double p_milliseconds);
+
+		/**
+		 * @brief	Publishes every frame with its corners and pose into shared memory, where tools in other
+		 *			processes can open it with SharedFrameRing::Open. The capture never waits for them.
+		 *			Set this before the capture is started.
+		 * @param	p_name The name of the shared memory
+		 * @param	p_slotCount How many frames the ring holds
+		 * @return	Whether the shared memory could be created
+		 */
+		bool SetSharedOutput(std::string p_name, int p_slotCount);
+
+		/**
+		 * @brief	Sets whether frames in which nothing changed skip the detection of the surface and the pencils.
+		 *			The corners, the pose and the pencils of the last analyzed frame are kept instead. Enabled by default.
+		 * @param	p_motionGating Whether to skip unchanged frames
+		 */
+		void SetMotionGating(bool p_motionGating);
+
+		/**
+		 * @brief	Sets whether the pose is filtered over time and its velocity is measured.
+		 *			Without it GetPredictedTransformMatrix returns the pose as it was measured. Enabled by default.
+		 * @param	p_posePrediction Whether to filter and predict the pose
+		 */
+		void SetPosePrediction(bool p_posePrediction);
+
+		/**
+		 * @brief	Sets whether Start only works on a frame when the frame source has one ready.
+		 *			Only used when the capture does not run in its own thread. Enabled by default,
+		 *			the caller then never waits for the camera and keeps the last published frame instead.
+		 * @param	p_asyncAcquisition Whether to poll the frame source instead of waiting for it
+		 */
+		void SetAsyncAcquisition(bool p_asyncAcquisition);
+
+		/**
+		 * @brief	Sets how many frames may wait between two stages. The newest frame always wins,
+		 *			so a larger depth only smooths out hiccups. Set this before the capture is started.
+		 * @param	p_depth The number of waiting frames
+		 */
+		void SetQueueDepth(int p_depth);
+
+		/**
+		 * @brief	The number of published frames that were never shown
+		 * @return	The number of dropped frames
+		 */
+		unsigned long GetDroppedFrameCount();
+
+		/**
+		 * @brief	The number of render frames that had to reuse the previous camera frame
+		 * @return	The number of reused frames
+		 */
+		unsigned long GetReusedFrameCount();
+
 	private:
 		typedef std::vector<cv::Point2f> Corners;
-		irr::video::ITexture* m_texture;
+		CameraTexture* m_texture;
 		irr::core::dimension2du m_resolution;
 		bool m_runInOwnThread;
 		CalibrationParams* m_params;
-		cv::VideoCapture m_capture;
+		FrameSource* m_frameSource;
 		PointDetector* m_pointDetector;
-		cv::Mat m_image;
-
-		bool m_running;
+		FrameBuffer* m_frameBuffer;
+		ColorClassifier* m_colorClassifier;
+		ColorModel* m_colorModel;
+		SegmentationMode m_segmentationMode;
+		int m_segmentationScale;
+		Corners m_refinedCorner;
+		int m_colorModelInterval;
+		int m_colorModelFrames;
+		float m_colorModelRate;
+		CornerTracker* m_cornerTracker;
+		MotionGate* m_motionGate;
+		bool m_motionGating;
+		bool m_surfaceLocked;
+		unsigned long m_analysis;
+
+		// The pencils of the last analyzed frame, only used by the thread that finds them
+		std::vector<irr::core::vector3df> m_pencilStarts;
+		std::vector<irr::core::vector3df> m_pencilEnds;
+		irr::core::matrix4 m_pencilCameraMatrix;
+		unsigned long m_pencilAnalysis;
+		bool m_pencilsCached;
+		unsigned long m_reusedPencilSets;
+		PoseEstimator* m_poseEstimator;
+		PosePredictor* m_posePredictor;
+		bool m_posePrediction;
+		// The pose is never extrapolated further than this, in seconds
+		double m_maxPrediction;
+		long long m_poseStartTicks;
+		ResolutionController* m_resolutionController;
+		bool m_resolutionScaling;
+		// The size of the frames at the start, what the texture and the pixel distance are measured in
+		cv::Size m_referenceSize;
+		// The camera mode the detection asked for, guarded by the mutex
+		cv::Size m_requestedSize;
+		// The camera mode the grab stage last asked the frame source for
+		cv::Size m_grabSize;
+		std::atomic<bool> m_modeSwitching;
+		SharedFrameRing* m_sharedRing;
+		DetectionWorkspace* m_workspace;
+		Corners m_detectedCorners;
+
+		std::atomic<bool> m_running;
 		std::thread* m_thread;
 		std::mutex* m_mutex;
 
-		bool m_chosen;
-		bool m_lost;
+		/**
+		 * @brief	The stages of the capture pipeline, in the order a frame passes through them
+		 */
+		enum Stage
+		{
+			STAGE_GRAB,
+			STAGE_RECTIFY,
+			STAGE_DETECT,
+			STAGE_TEXTURE,
+			STAGE_COUNT
+		};
+
+		bool m_pipelined;
+		bool m_asyncAcquisition;
+		unsigned long m_notReadyPolls;
+		FrameQueue* m_grabQueue;
+		FrameQueue* m_rectifyQueue;
+		FrameQueue* m_detectQueue;
+		std::thread* m_stageThreads[STAGE_COUNT];
+		std::atomic<unsigned long> m_stageFrames[STAGE_COUNT];
+		std::atomic<long long> m_stageTicks[STAGE_COUNT];
+		Utility::LatencyHistogram* m_stageHistograms[STAGE_COUNT];
+		Utility::LatencyHistogram* m_uploadHistogram;
+		int64 m_startTicks;
+
+		std::atomic<bool> m_chosen;
+		bool m_selectionChanged;
+		cv::Point2f m_selection;
 		cv::Size m_size;
 		cv::Size m_sizeHalfed;
 		cv::Point2f m_center;
@@ -159,12 +472,29 @@ namespace Camera
 		float m_fov;
 		float m_defaultRotation;
 
+		bool m_roiTracking;
+		int m_roiMargin;
+		int m_roiMaxLostFrames;
+		int m_lostFrames;
+		std::atomic<unsigned long> m_roiHits;
+		std::atomic<unsigned long> m_roiFallbacks;
+
+		bool m_cornerTracking;
+		std::atomic<unsigned long> m_trackedFrames;
+		std::atomic<unsigned long> m_redetections;
+
+		UndistortMode m_undistortMode;
+		int m_backgroundUndistortInterval;
+		unsigned long m_frameCount;
+
 		cv::Point2f m_topLeft;
+		Corners m_imageCorners;
 		Corners m_corners;
 		irr::core::line2df m_shortestLine;
 		irr::core::line2df m_longestLine;
 		float m_lineRatio;
 		irr::core::line2df m_shortestGameLine;
+		irr::core::matrix4 m_transformation;
 
 		/**
 		 * @brief	Locks the mutex with this thread
@@ -177,25 +507,163 @@ namespace Camera
 		void Unlock();
 
 		/**
-		 * @brief	Updates the texture to the latest frame of the camera
+		 * @brief	Runs every stage of the pipeline once, one after another
 		 */
 		void Work();
 
 		/**
-		 * @brief	Thread worker
+		 * @brief	Thread worker that runs the whole pipeline on a single thread
 		 * @see		Capture::Work
 		 */
 		void Worker();
 
 		/**
-		 * @brief	Fetches a image from the capture and undistort the image
+		 * @brief	Thread worker that runs a single stage of the pipeline
+		 * @param	p_stage The stage to run
+		 */
+		void StageWorker(int p_stage);
+
+		/**
+		 * @brief	Runs a stage once and keeps its statistics
+		 * @param	p_stage The stage to run
+		 * @return	Whether the stage processed a frame
+		 */
+		bool RunStage(int p_stage);
+
+		/**
+		 * @brief	Gets the queue a stage takes its frames from
+		 * @param	p_stage The stage
+		 * @return	The input queue, NULL for the grab stage
+		 */
+		FrameQueue* GetStageInput(int p_stage);
+
+		/**
+		 * @brief	Reads a frame from the frame source
+		 * @return	Whether a frame was read
+		 */
+		bool GrabStage();
+
+		/**
+		 * @brief	Undistorts the newest grabbed frame, in UNDISTORT_POINTS mode the frame is passed on as is
+		 * @return	Whether a frame was processed
+		 */
+		bool RectifyStage();
+
+		/**
+		 * @brief	Finds the surface in the newest rectified frame and calculates its transformation
+		 * @return	Whether a frame was processed
+		 */
+		bool DetectStage();
+
+		/**
+		 * @brief	Converts the newest detected frame for the texture and publishes it to the render thread
+		 * @return	Whether a frame was processed
+		 */
+		bool TextureStage();
+
+		/**
+		 * @brief	Logs the number of frames and the occupancy of every stage and the drops of every queue
+		 */
+		void LogPipelineStatistics();
+
+		/**
+		 * @brief	Copies the latest selection made with the mouse to the capture thread
+		 * @return	Whether the selection changed
+		 */
+		bool UpdateSelection();
+
+		/**
+		 * @brief	Moves everything that is kept in frame coordinates to frames of another size
+		 * @param	p_size The size of the new frames
+		 */
+		void Resize(cv::Size p_size);
+
+		/**
+		 * @brief	Takes over the camera mode and the detection scale the resolution controller chose
+		 */
+		void ApplyResolution();
+
+		/**
+		 * @brief	Detects the surface by its color and the contours around it
+		 * @param	p_image The frame to detect in, debug shapes are drawn on it
+		 * @param	p_region The part of the frame to search
+		 * @param	p_corners Receives the four sorted corners in frame coordinates
+		 * @return	Whether the surface was found
+		 */
+		bool DetectCorners(cv::Mat& p_image, cv::Rect p_region, Corners& p_corners);
+
+		/**
+		 * @brief	Refines corners found in a downscaled frame to sub-pixel precision in the full frame
+		 * @param	p_image The full frame
+		 * @param	p_corners The corners in frame coordinates, refined in place
+		 * @param	p_scale How many times smaller the frame was in which the corners were found
+		 */
+		void RefineCorners(const cv::Mat& p_image, Corners& p_corners, int p_scale);
+
+		/**
+		 * @brief	Tracks or detects the surface and updates the corners and the transform matrix
+		 * @param	p_image The frame to analyze, debug shapes are drawn on it
+		 * @return	Whether the surface was found
+		 */
+		bool AnalyzeSurface(cv::Mat& p_image);
+
+		/**
+		 * @brief	Moves the bounding box, the center and the top left corner along with the tracked corners
+		 * @param	p_corners The tracked corners
+		 */
+		void UpdateBoundingBox(const Corners& p_corners);
+
+		/**
+		 * @brief	Gets the part of the frame in which to search for the surface
+		 * @param	p_imageSize The size of the frame
+		 * @return	The region around the last known surface, or the whole frame
+		 */
+		cv::Rect GetSearchRegion(cv::Size p_imageSize);
+
+		/**
+		 * @brief	Keeps track of lost frames and the region counters
+		 * @param	p_lost Whether the surface was lost in this frame
+		 * @param	p_usedRegion Whether only a region of the frame was searched
+		 */
+		void UpdateTrackingState(bool p_lost, bool p_usedRegion);
+
+		/**
+		 * @brief	Calculates the HSV range around the chosen color
+		 * @param	p_lower Receives the lower bound
+		 * @param	p_upper Receives the upper bound
+		 */
+		void GetColorRange(cv::Scalar& p_lower, cv::Scalar& p_upper);
+
+		/**
+		 * @brief	Converts the image into the irrlicht texture
+		 * @param	p_image The BGR image to show
+		 */
+		void CopyToTexture(const cv::Mat& p_image);
+
+		/**
+		 * @brief	Segments the chosen surface with the color model on a downscaled copy of the region.
+		 *			The model is first learned from the area around the clicked point.
+		 * @param	p_image The frame
+		 * @param	p_region The part of the frame to search in
+		 * @return	The mask of the surface, m_segmentationScale times smaller than the region
+		 */
+		cv::Mat SegmentSurface(const cv::Mat& p_image, cv::Rect p_region);
+
+		/**
+		 * @brief	Lets the color model learn from the inside of the surface
+		 * @param	p_image The frame
+		 * @param	p_corners The corners of the surface in frame coordinates
 		 */
-		void CaptureAndUndistort();
+		void UpdateColorModel(const cv::Mat& p_image, const Corners& p_corners);
 
 		/**
-		 * @brief	Copies the image to the irrlicht texture
+		 * @brief	Calculates the transform matrix from the current corners.
+		 *			The pose of the surface is estimated relative to the camera and then moved into the world
+		 *			through the game camera, which hangs at the pixel distance looking down at the table.
+		 *			When no pose could be estimated the previous transform matrix is kept.
+		 * @return	The transform matrix for the root scene node
 		 */
-		void CopyToTexture();
+		irr::core::matrix4 CalculateTransformMatrix();
 
 		/**
 		 * @brief	Compues the intersections of two lines
@@ -218,7 +686,7 @@ namespace Camera
 		 *			This can be used to determin the ratio.
 		 * @param	p_corners The corners to use as lines and check for the longest line
 		 */
-		void CalculateShortestAndLongestLine(Corners p_corners);
+		void CalculateShortestAndLongestLine(const Corners& p_corners);
 	};
 }
 
@@ -0,0 +1,105 @@
+#ifndef __CAMERA__COLORCLASSIFIER__H__
+#define __CAMERA__COLORCLASSIFIER__H__
+
+#include <opencv/cv.h>
+#include <vector>
+
+namespace Camera
+{
+	/**
+	 * @brief	Classifies BGR pixels into a binary mask in a single pass.
+	 *			The result is identical to cv::cvtColor(CV_BGR2HSV) followed by cv::inRange,
+	 *			because the lookup table is built with exactly those two calls for every possible BGR color.
+	 *			The table is only rebuilt when the range changes, so set the range once the color is known.
+	 * @author	Bas Stroosnijder
+	 */
+	class ColorClassifier
+	{
+	public:
+		/**
+		 * @brief	Constructor
+		 */
+		ColorClassifier();
+
+		/**
+		 * @brief	Destructor
+		 */
+		~ColorClassifier();
+
+		/**
+		 * @brief	Sets the HSV range that is classified as inside. Rebuilds the lookup table when it changed.
+		 * @param	p_lower The inclusive lower HSV bound, as passed to cv::inRange
+		 * @param	p_upper The inclusive upper HSV bound, as passed to cv::inRange
+		 */
+		void SetRange(cv::Scalar p_lower, cv::Scalar p_upper);
+
+		/**
+		 * @brief	Classifies a BGR image into a mask with 255 for pixels inside the range and 0 for pixels outside.
+		 *			The work is split over all cores; AVX2 is used when the processor supports it.
+		 * @param	p_image The BGR image
+		 * @param	p_mask The mask, its buffer is reused when the size matches
+		 */
+		void Classify(const cv::Mat& p_image, cv::Mat& p_mask);
+
+		/**
+		 * @brief	Whether a range has been set and the lookup table is ready
+		 * @return	Whether the classifier is ready
+		 */
+		bool IsReady();
+
+		/**
+		 * @brief	Whether the AVX2 kernel is used
+		 * @return	Whether the AVX2 kernel is used
+		 */
+		bool IsUsingAvx2();
+
+		/**
+		 * @brief	Enables or disables the AVX2 kernel, it is only enabled when the processor supports it
+		 * @param	p_useAvx2 Whether to use the AVX2 kernel
+		 */
+		void SetUseAvx2(bool p_useAvx2);
+
+	private:
+		// One bit for every 24-bit BGR color
+		std::vector<unsigned int> m_table;
+		// Expands the 8 bits of a byte to 8 bytes of 0 or 255
+		unsigned long long m_expand[256];
+		cv::Scalar m_lower;
+		cv::Scalar m_upper;
+		bool m_ready;
+		bool m_hasAvx2;
+		bool m_useAvx2;
+
+		/**
+		 * @brief	Rebuilds the lookup table for the current range
+		 */
+		void BuildTable();
+
+		/**
+		 * @brief	Checks whether the processor and the operating system support AVX2
+		 * @return	Whether AVX2 can be used
+		 */
+		static bool DetectAvx2();
+
+		/**
+		 * @brief	Classifies a single row without SIMD instructions
+		 * @param	p_source The BGR pixels of the row
+		 * @param	p_destination The mask pixels of the row
+		 * @param	p_width The number of pixels in the row
+		 */
+		void ClassifyRowScalar(const unsigned char* p_source, unsigned char* p_destination, int p_width) const;
+
+		/**
+		 * @brief	Classifies a single row with the AVX2 gather instruction
+		 * @param	p_source The BGR pixels of the row
+		 * @param	p_destination The mask pixels of the row
+		 * @param	p_width The number of pixels in the row
+		 */
+		void ClassifyRowAvx2(const unsigned char* p_source, unsigned char* p_destination, int p_width) const;
+
+		friend class ColorClassifierBody;
+		friend class ColorTableBody;
+	};
+}
+
+#endif
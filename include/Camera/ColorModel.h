@@ -0,0 +1,74 @@
+#ifndef __CAMERA__COLORMODEL__H__
+#define __CAMERA__COLORMODEL__H__
+
+#include <opencv/cv.h>
+
+namespace Camera
+{
+	/**
+	 * @brief	Learned hue-saturation model of the color of the surface.
+	 *			The model is a 2D histogram that starts from the area around the clicked point and keeps
+	 *			learning from the inside of the surface while it is tracked, so it follows changes in the light.
+	 *			Value is left out of the model, which makes it hold up against shadows.
+	 *			Segmenting is a back-projection of the histogram followed by a threshold,
+	 *			which gives masks that need no more than a small opening to be clean.
+	 * @author	Bas Stroosnijder
+	 */
+	class ColorModel
+	{
+	public:
+		/**
+		 * @brief	Constructor
+		 */
+		ColorModel();
+
+		/**
+		 * @brief	Destructor
+		 */
+		~ColorModel();
+
+		/**
+		 * @brief	Forgets everything that was learned
+		 */
+		void Reset();
+
+		/**
+		 * @brief	Whether something has been learned
+		 * @return	Whether the model can segment
+		 */
+		bool IsReady();
+
+		/**
+		 * @brief	Learns the colors of an area. The first call replaces the model,
+		 *			later calls blend the new colors into it.
+		 * @param	p_hsv The HSV image to learn from
+		 * @param	p_mask The pixels of p_hsv that belong to the surface, empty to use all of them
+		 * @param	p_rate How much the new colors weigh, between 0 and 1
+		 */
+		void Learn(const cv::Mat& p_hsv, const cv::Mat& p_mask, float p_rate);
+
+		/**
+		 * @brief	Marks the pixels that have the color of the surface
+		 * @param	p_hsv The HSV image to segment
+		 * @param	p_mask Receives 255 for pixels of the surface and 0 for the others
+		 */
+		void Segment(const cv::Mat& p_hsv, cv::Mat& p_mask);
+
+		/**
+		 * @brief	Sets how likely a color has to be before it counts as the surface
+		 * @param	p_threshold The threshold between 0 and 255, 40 by default
+		 */
+		void SetThreshold(int p_threshold);
+
+	private:
+		static const int C_HUE_BINS = 30;
+		static const int C_SATURATION_BINS = 32;
+
+		cv::Mat m_histogram;
+		cv::Mat m_sample;
+		bool m_ready;
+		int m_threshold;
+	};
+}
+
+#endif
@@ -0,0 +1,101 @@
+#ifndef __CAMERA__CORNERTRACKER__H__
+#define __CAMERA__CORNERTRACKER__H__
+
+#include <opencv/cv.h>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace Camera
+{
+	/**
+	 * @brief	Follows the four corners of the surface from frame to frame with pyramidal Lucas-Kanade optical flow.
+	 *			Only a grey window around the corners is converted and searched, and every tracked corner
+	 *			is refined to sub-pixel precision. The corners are tracked forwards and back again;
+	 *			when they do not return to where they started the tracking is no longer trusted
+	 *			and the surface has to be detected again.
+	 * @author	Bas Stroosnijder
+	 */
+	class CornerTracker
+	{
+	public:
+		/**
+		 * @brief	Constructor
+		 */
+		CornerTracker();
+
+		/**
+		 * @brief	Destructor
+		 */
+		~CornerTracker();
+
+		/**
+		 * @brief	Starts tracking corners that were validated by the detection
+		 * @param	p_image The BGR frame the corners were found in
+		 * @param	p_corners The four sorted corners in frame coordinates
+		 */
+		void Start(const cv::Mat& p_image, const std::vector<cv::Point2f>& p_corners);
+
+		/**
+		 * @brief	Tracks the corners into the next frame
+		 * @param	p_image The next BGR frame
+		 * @param	p_corners Receives the tracked corners in the same order as they were started with
+		 * @return	Whether the corners could be tracked with enough confidence, tracking stops when they could not
+		 */
+		bool Track(const cv::Mat& p_image, std::vector<cv::Point2f>& p_corners);
+
+		/**
+		 * @brief	Stops tracking, the next frame has to be detected again
+		 */
+		void Reset();
+
+		/**
+		 * @brief	Whether corners are being tracked
+		 * @return	Whether corners are being tracked
+		 */
+		bool IsTracking();
+
+		/**
+		 * @brief	Sets how far a corner may end up from where it started after tracking it forwards and back
+		 * @param	p_maxError The maximum forward-backward error in pixels
+		 */
+		void SetMaxError(float p_maxError);
+
+		/**
+		 * @brief	The largest forward-backward error of the last tracked frame
+		 * @return	The error in pixels
+		 */
+		float GetLastError();
+
+	private:
+		bool m_tracking;
+		float m_maxError;
+		float m_lastError;
+		double m_area;
+		std::vector<cv::Point2f> m_corners;
+		// The grey window of the previous frame and where it is in the frame
+		cv::Mat m_previousWindow;
+		cv::Rect m_previousRegion;
+		cv::Mat m_window;
+		cv::Size m_windowSize;
+		int m_maxLevel;
+		int m_margin;
+
+		/**
+		 * @brief	Calculates the window around the corners in which they are searched in the next frame
+		 * @param	p_imageSize The size of the frame
+		 * @return	The window in frame coordinates
+		 */
+		cv::Rect GetRegion(cv::Size p_imageSize);
+
+		/**
+		 * @brief	Converts a window of the frame to grey
+		 * @param	p_image The BGR frame
+		 * @param	p_region The window to convert
+		 * @param	p_window Receives the grey window
+		 */
+		void ConvertWindow(const cv::Mat& p_image, cv::Rect p_region, cv::Mat& p_window);
+	};
+}
+
+#endif
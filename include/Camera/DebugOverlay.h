@@ -0,0 +1,261 @@
+#ifndef __CAMERA__DEBUGOVERLAY__H__
+#define __CAMERA__DEBUGOVERLAY__H__
+
+#include "Utility/Logger.h"
+#include <opencv/cv.h>
+#include <opencv/highgui.h>
+#include <atomic>
+#include <vector>
+#include <string>
+#include <sstream>
+#include <iomanip>
+#include <cstring>
+#include <algorithm>
+
+namespace Camera
+{
+	/**
+	 * @brief	Collects what the detectors want to show about a frame, so they never have to draw or wait for a window themselves.
+	 *			Detectors add points, lines, rectangles and labels to a ring of fixed size. Adding never blocks or allocates,
+	 *			when the ring is full the primitive is dropped. Nothing is added at all while the overlay is disabled,
+	 *			which it is by default, so the detectors only pay for a single check.
+	 *			The render thread takes the primitives out with Update and shows them in a window, writes them to disk
+	 *			on top of the camera frame or lets the game draw them over the scene.
+	 *			Positions are stored relative to the size of the image they were found in, so they fit on any image.
+	 *
+	 *			Adding, from any thread:
+	 *			DebugOverlay* overlay = DebugOverlay::GetInstance();
+	 *			if (overlay->IsEnabled())
+	 *			{
+	 *				overlay->Clear(DebugOverlay::SOURCE_PENCILS);
+	 *				overlay->AddPoint(DebugOverlay::SOURCE_PENCILS, point, image.size(), cv::Scalar(0, 0, 255));
+	 *			}
+	 * @author	Bas Stroosnijder
+	 */
+	class DebugOverlay
+	{
+	public:
+		/**
+		 * @brief	Where the primitives end up
+		 */
+		enum Output
+		{
+			OUTPUT_NONE,
+			// An OpenCV window with the camera frame
+			OUTPUT_WINDOW,
+			// Images of the camera frame in the directory, one for every change
+			OUTPUT_DISK,
+			// Drawn by the game over the scene
+			OUTPUT_GUI
+		};
+
+		/**
+		 * @brief	Who added a primitive, a source clears only its own primitives
+		 */
+		enum Source
+		{
+			SOURCE_SURFACE,
+			SOURCE_PENCILS,
+			SOURCE_COUNT
+		};
+
+		/**
+		 * @brief	The kind of a primitive
+		 */
+		enum Type
+		{
+			TYPE_CLEAR,
+			TYPE_POINT,
+			TYPE_LINE,
+			TYPE_RECTANGLE,
+			TYPE_LABEL
+		};
+
+		/**
+		 * @brief	One thing to draw, positions are between 0 and 1 of the width and the height of the image
+		 */
+		struct Primitive
+		{
+			Type m_type;
+			Source m_source;
+			// A point, the start of a line, the top left of a rectangle or the start of a label
+			float m_x1;
+			float m_y1;
+			// The end of a line or the bottom right of a rectangle
+			float m_x2;
+			float m_y2;
+			// The radius of a point relative to the width of the image
+			float m_radius;
+			unsigned char m_blue;
+			unsigned char m_green;
+			unsigned char m_red;
+			char m_label[48];
+		};
+
+		/**
+		 * @brief	Constructor
+		 */
+		DebugOverlay();
+
+		/**
+		 * @brief	Destructor, closes the window
+		 */
+		~DebugOverlay();
+
+		/**
+		 * @brief	Returns a Singleton-instance of the DebugOverlay.
+		 *			The instance is created without a lock, so the first call has to happen before other threads use it.
+		 */
+		static DebugOverlay* GetInstance();
+
+		/**
+		 * @brief	Destroys the Singleton-instance of the DebugOverlay
+		 */
+		static void ResetInstance();
+
+		/**
+		 * @brief	Sets where the primitives end up, OUTPUT_NONE disables the overlay
+		 * @param	p_output The output
+		 */
+		void SetOutput(Output p_output);
+
+		/**
+		 * @brief	Where the primitives end up
+		 * @return	The output
+		 */
+		Output GetOutput();
+
+		/**
+		 * @brief	Whether primitives are collected, check this before working out what to add
+		 * @return	Whether the overlay is enabled
+		 */
+		bool IsEnabled();
+
+		/**
+		 * @brief	Sets the directory OUTPUT_DISK writes the images to
+		 * @param	p_directory The directory, without a separator at the end
+		 */
+		void SetDirectory(const std::string& p_directory);
+
+		/**
+		 * @brief	Removes what a source added before, from the moment the render thread gets to it
+		 * @param	p_source The source
+		 */
+		void Clear(Source p_source);
+
+		/**
+		 * @brief	Adds a point
+		 * @param	p_source The source
+		 * @param	p_point The point in the image
+		 * @param	p_imageSize The size of the image
+		 * @param	p_color The BGR color
+		 * @param	p_radius The radius in pixels of the image
+		 */
+		void AddPoint(Source p_source, cv::Point2f p_point, cv::Size p_imageSize, cv::Scalar p_color, float p_radius = 4.0f);
+
+		/**
+		 * @brief	Adds a line
+		 * @param	p_source The source
+		 * @param	p_start The start in the image
+		 * @param	p_end The end in the image
+		 * @param	p_imageSize The size of the image
+		 * @param	p_color The BGR color
+		 */
+		void AddLine(Source p_source, cv::Point2f p_start, cv::Point2f p_end, cv::Size p_imageSize, cv::Scalar p_color);
+
+		/**
+		 * @brief	Adds the outline of a rectangle
+		 * @param	p_source The source
+		 * @param	p_rectangle The rectangle in the image
+		 * @param	p_imageSize The size of the image
+		 * @param	p_color The BGR color
+		 */
+		void AddRectangle(Source p_source, cv::Rect p_rectangle, cv::Size p_imageSize, cv::Scalar p_color);
+
+		/**
+		 * @brief	Adds a label, text that does not fit is cut off
+		 * @param	p_source The source
+		 * @param	p_text The text
+		 * @param	p_position The bottom left of the text in the image
+		 * @param	p_imageSize The size of the image
+		 * @param	p_color The BGR color
+		 */
+		void AddLabel(Source p_source, const std::string& p_text, cv::Point2f p_position, cv::Size p_imageSize, cv::Scalar p_color);
+
+		/**
+		 * @brief	Takes the primitives out of the ring. Only for the render thread.
+		 * @return	Whether anything changed since the last update
+		 */
+		bool Update();
+
+		/**
+		 * @brief	The primitives that are shown right now. Only for the render thread.
+		 * @return	The primitives, valid until the next Update
+		 */
+		const std::vector<Primitive>& GetPrimitives();
+
+		/**
+		 * @brief	Draws the primitives that are shown right now onto an image
+		 * @param	p_image The BGR image to draw on
+		 */
+		void Draw(cv::Mat& p_image);
+
+		/**
+		 * @brief	Shows the camera frame with the primitives in the window or writes it to disk, depending on the output.
+		 *			Only for the render thread.
+		 * @param	p_frame The camera frame
+		 * @param	p_changed Whether the primitives changed, the disk only gets an image when they did
+		 */
+		void Show(const cv::Mat& p_frame, bool p_changed);
+
+		/**
+		 * @brief	The number of primitives that did not fit in the ring
+		 * @return	The number of dropped primitives
+		 */
+		unsigned long GetDroppedCount();
+
+	private:
+		// The number of primitives in the ring, a power of two
+		static const unsigned int C_CAPACITY = 1024;
+		static const char* C_WINDOW_NAME;
+
+		/**
+		 * @brief	A place in the ring, the sequence tells whether it holds a primitive or may be written
+		 */
+		struct Slot
+		{
+			std::atomic<unsigned int> m_sequence;
+			Primitive m_primitive;
+		};
+
+		static DebugOverlay* m_debugOverlay;
+		std::atomic<int> m_output;
+		std::string m_directory;
+		Slot m_slots[C_CAPACITY];
+		std::atomic<unsigned int> m_tail;
+		unsigned int m_head;
+		std::atomic<unsigned long> m_dropped;
+		// What the render thread shows, with the primitives of every source together
+		std::vector<Primitive> m_primitives;
+		cv::Mat m_canvas;
+		bool m_windowOpened;
+		unsigned long m_written;
+
+		/**
+		 * @brief	Fills in the parts every primitive has
+		 * @param	p_type The type
+		 * @param	p_source The source
+		 * @param	p_color The BGR color
+		 * @return	The primitive
+		 */
+		static Primitive MakePrimitive(Type p_type, Source p_source, cv::Scalar p_color);
+
+		/**
+		 * @brief	Puts a primitive in the ring without waiting, it is dropped when the ring is full
+		 * @param	p_primitive The primitive
+		 */
+		void Push(const Primitive& p_primitive);
+	};
+}
+
+#endif
@@ -0,0 +1,120 @@
+#ifndef __CAMERA__DETECTIONWORKSPACE__H__
+#define __CAMERA__DETECTIONWORKSPACE__H__
+
+#include <opencv/cv.h>
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+namespace Camera
+{
+	/**
+	 * @brief	Scratch memory for one detection thread that is kept from frame to frame.
+	 *			Images are handed out as continuous images of the exact size on buffers that only grow, contours are found
+	 *			with a memory storage that is cleared instead of freed and copied into flat point storage.
+	 *			After the first few frames nothing has to be allocated anymore, which is checked
+	 *			by comparing the buffers before and after every frame.
+	 *			A workspace may only be used by one thread at a time.
+	 * @author	Bas Stroosnijder
+	 */
+	class DetectionWorkspace
+	{
+	public:
+		/**
+		 * @brief	The image buffers in the workspace
+		 */
+		enum Buffer
+		{
+			BUFFER_SCALED,
+			BUFFER_CONVERTED,
+			BUFFER_MASK,
+			BUFFER_FILTERED,
+			BUFFER_EDGES,
+			BUFFER_GREY,
+			BUFFER_COUNT
+		};
+
+		/**
+		 * @brief	Constructor
+		 */
+		DetectionWorkspace();
+
+		/**
+		 * @brief	Destructor
+		 */
+		~DetectionWorkspace();
+
+		/**
+		 * @brief	Marks the start of a frame, the buffers are remembered to see if they are reallocated
+		 */
+		void Begin();
+
+		/**
+		 * @brief	Marks the end of a frame and counts it when any buffer had to be reallocated
+		 */
+		void End();
+
+		/**
+		 * @brief	Gets a continuous image on an image buffer, the buffer only grows when the image does not fit
+		 * @param	p_buffer The buffer to use
+		 * @param	p_size The size of the image
+		 * @param	p_type The OpenCV type of the image
+		 * @return	An image of exactly p_size at the start of the buffer, valid until the buffer grows
+		 */
+		cv::Mat GetImage(Buffer p_buffer, cv::Size p_size, int p_type);
+
+		/**
+		 * @brief	Finds the outer and inner contours in a binary image, the image is modified
+		 * @param	p_image The binary image
+		 * @param	p_offset The offset added to every point
+		 * @return	The number of contours found
+		 */
+		int FindContours(cv::Mat& p_image, cv::Point p_offset);
+
+		/**
+		 * @brief	Gets a contour found by the last call to FindContours
+		 * @param	p_index The index of the contour
+		 * @return	A view on the points of the contour, only valid until the next call to FindContours
+		 */
+		cv::Mat GetContour(int p_index);
+
+		/**
+		 * @brief	Approximates a contour with a polygon in floating point coordinates
+		 * @param	p_index The index of the contour
+		 * @return	The corners of the polygon, only valid until the next approximation
+		 */
+		std::vector<cv::Point2f>& ApproximateContour(int p_index);
+
+		/**
+		 * @brief	The number of frames that needed to allocate memory in the workspace
+		 * @return	The number of frames with a reallocation
+		 */
+		unsigned long GetReallocationCount();
+
+	private:
+		cv::Mat m_images[BUFFER_COUNT];
+		CvMemStorage* m_storage;
+		std::vector<cv::Point> m_points;
+		std::vector<int> m_contourStarts;
+		std::vector<cv::Point2f> m_curve;
+		std::vector<cv::Point2f> m_approx;
+
+		// What the buffers looked like at Begin
+		unsigned char* m_imageData[BUFFER_COUNT];
+		size_t m_pointsCapacity;
+		size_t m_contourStartsCapacity;
+		size_t m_curveCapacity;
+		size_t m_approxCapacity;
+		int m_storageBlocks;
+
+		std::atomic<unsigned long> m_reallocations;
+
+		/**
+		 * @brief	Counts the blocks the memory storage has allocated
+		 * @return	The number of blocks
+		 */
+		int CountStorageBlocks();
+	};
+}
+
+#endif
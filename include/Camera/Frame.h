@@ -0,0 +1,55 @@
+#ifndef __CAMERA__FRAME__H__
+#define __CAMERA__FRAME__H__
+
+#include <irrlicht.h>
+#include <opencv/cv.h>
+#include <vector>
+
+namespace Camera
+{
+	/**
+	 * @brief	A snapshot of everything the capture thread produced for one camera frame.
+	 *			Once published through the FrameBuffer a frame is only read, never written.
+	 * @see		FrameBuffer
+	 * @author	Bas Stroosnijder
+	 */
+	struct Frame
+	{
+	public:
+		unsigned long m_sequence;
+		// When the frame source delivered the image, in milliseconds
+		double m_timestamp;
+		// When the frame was read, in Profiler ticks, the clock the render thread uses as well
+		long long m_acquiredTicks;
+		cv::Mat m_image;
+		cv::Mat m_background;
+		bool m_backgroundUpdated;
+		// The background scaled to the size of the texture, empty when it already has that size
+		cv::Mat m_textureImage;
+		std::vector<cv::Point2f> m_imageCorners;
+		std::vector<cv::Point2f> m_corners;
+		bool m_lost;
+		float m_pixelDistance;
+		float m_lineRatio;
+		irr::core::matrix4 m_transformation;
+		// How fast the transformation moves, to move it ahead to the moment the frame is displayed
+		irr::core::vector3df m_velocity;
+		cv::Vec3d m_angularVelocity;
+		// Counts the frames the surface was analyzed on, frames with the same count share their results
+		unsigned long m_analysis;
+
+		/**
+		 * @brief	Constructs an empty frame in which the surface is lost
+		 */
+		Frame();
+
+		/**
+		 * @brief	Takes over another frame. The images are swapped instead of copied,
+		 *			so both frames keep reusing their buffers; everything else is copied.
+		 * @param	p_other The frame to take over
+		 */
+		void MoveFrom(Frame& p_other);
+	};
+}
+
+#endif
@@ -0,0 +1,87 @@
+#ifndef __CAMERA__FRAMEBUFFER__H__
+#define __CAMERA__FRAMEBUFFER__H__
+
+#include "Frame.h"
+#include <atomic>
+
+namespace Camera
+{
+	/**
+	 * @brief	Lock-free triple buffer used to hand frames from the capture thread to the render thread.
+	 *			The writer always owns the back frame and the reader always owns the front frame,
+	 *			so neither of them ever waits for the other and a cv::Mat is never reused while it is read.
+	 *			Exactly one thread may write and exactly one thread may read.
+	 * @author	Bas Stroosnijder
+	 */
+	class FrameBuffer
+	{
+	public:
+		/**
+		 * @brief	Constructor
+		 */
+		FrameBuffer();
+
+		/**
+		 * @brief	Destructor
+		 */
+		~FrameBuffer();
+
+		/**
+		 * @brief	Gets the frame the writer may fill in. Only call this from the writing thread.
+		 * @return	The back frame
+		 */
+		Frame& GetBackFrame();
+
+		/**
+		 * @brief	Publishes the back frame and hands the writer a new back frame.
+		 *			If the previously published frame was never acquired it is counted as dropped.
+		 */
+		void Publish();
+
+		/**
+		 * @brief	Takes the newest published frame without waiting. Only call this from the reading thread.
+		 *			If nothing new was published the current front frame is kept and counted as reused.
+		 * @return	Whether a new frame was acquired
+		 */
+		bool Acquire();
+
+		/**
+		 * @brief	Gets the frame the reader owns. Only call this from the reading thread.
+		 * @return	The front frame
+		 */
+		const Frame& GetFrontFrame();
+
+		/**
+		 * @brief	The number of frames that have been published
+		 * @return	The number of frames that have been published
+		 */
+		unsigned long GetPublishedCount();
+
+		/**
+		 * @brief	The number of published frames that were overwritten before the reader acquired them
+		 * @return	The number of dropped frames
+		 */
+		unsigned long GetDroppedCount();
+
+		/**
+		 * @brief	The number of times the reader had to keep using its previous frame
+		 * @return	The number of reused frames
+		 */
+		unsigned long GetReusedCount();
+
+	private:
+		// Marks the middle index as containing a frame the reader has not seen yet
+		static const int C_FRESH = 4;
+		static const int C_INDEX_MASK = 3;
+
+		Frame m_frames[3];
+		int m_back;
+		int m_front;
+		std::atomic<int> m_middle;
+		std::atomic<unsigned long> m_published;
+		std::atomic<unsigned long> m_dropped;
+		std::atomic<unsigned long> m_reused;
+	};
+}
+
+#endif
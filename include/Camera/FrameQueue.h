@@ -0,0 +1,132 @@
+#ifndef __CAMERA__FRAMEQUEUE__H__
+#define __CAMERA__FRAMEQUEUE__H__
+
+#include "Frame.h"
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+namespace Camera
+{
+	/**
+	 * @brief	Bounded lock-free queue that hands frames from one pipeline stage to the next.
+	 *			The frames live in the queue itself; the producer fills the write frame in place
+	 *			and the consumer works on the read frame in place, so no image is ever copied.
+	 *			The newest frame always wins: a full queue drops its oldest frame when a new one is pushed,
+	 *			and the consumer skips every waiting frame except the newest.
+	 *			Exactly one thread may push and exactly one thread may pop.
+	 * @author	Bas Stroosnijder
+	 */
+	class FrameQueue
+	{
+	public:
+		/**
+		 * @brief	Constructor
+		 * @param	p_depth The number of frames that can wait in the queue
+		 */
+		FrameQueue(int p_depth = 1);
+
+		/**
+		 * @brief	Destructor
+		 */
+		~FrameQueue();
+
+		/**
+		 * @brief	Gets the frame the producer may fill in. Only call this from the producing thread.
+		 * @return	The write frame
+		 */
+		Frame& GetWriteFrame();
+
+		/**
+		 * @brief	Queues the write frame and hands the producer a new write frame.
+		 *			When the queue is full the oldest waiting frame is dropped.
+		 */
+		void Push();
+
+		/**
+		 * @brief	Takes the newest queued frame, older waiting frames are dropped.
+		 *			Only call this from the consuming thread.
+		 * @return	Whether a frame was taken
+		 */
+		bool Pop();
+
+		/**
+		 * @brief	Waits until a frame is queued or the timeout passes
+		 * @param	p_milliseconds The timeout in milliseconds
+		 */
+		void Wait(int p_milliseconds);
+
+		/**
+		 * @brief	Gets the frame the consumer took last. Only call this from the consuming thread.
+		 * @return	The read frame
+		 */
+		Frame& GetReadFrame();
+
+		/**
+		 * @brief	The number of frames that can wait in the queue
+		 * @return	The depth
+		 */
+		int GetDepth();
+
+		/**
+		 * @brief	The number of pushed frames
+		 * @return	The number of pushed frames
+		 */
+		unsigned long GetPushedCount();
+
+		/**
+		 * @brief	The number of pushed frames that were never taken by the consumer
+		 * @return	The number of dropped frames
+		 */
+		unsigned long GetDroppedCount();
+
+		/**
+		 * @brief	The average number of waiting frames, measured every time a frame is pushed
+		 * @return	The average queue depth
+		 */
+		double GetAverageDepth();
+
+	private:
+		std::vector<Frame> m_frames;
+		int m_depth;
+
+		// Indices of the waiting frames, the producer moves the head and both sides may move the tail
+		std::atomic<int>* m_queued;
+		std::atomic<unsigned int> m_head;
+		std::atomic<unsigned int> m_tail;
+
+		// Indices of frames the consumer is done with, handed back to the producer
+		std::vector<int> m_free;
+		std::atomic<unsigned int> m_freeHead;
+		std::atomic<unsigned int> m_freeTail;
+
+		int m_write;
+		int m_read;
+
+		std::mutex m_waitMutex;
+		std::condition_variable m_waitCondition;
+
+		std::atomic<unsigned long> m_pushed;
+		std::atomic<unsigned long> m_dropped;
+		std::atomic<unsigned long long> m_depthSum;
+
+		/**
+		 * @brief	Takes the oldest waiting frame
+		 * @param	p_index Receives the index of the frame
+		 * @return	Whether a frame was waiting
+		 */
+		bool TakeOldest(int& p_index);
+
+		/**
+		 * @brief	Hands a frame back to the producer. Only call this from the consuming thread.
+		 * @param	p_index The index of the frame
+		 */
+		void Release(int p_index);
+	};
+}
+
+#endif
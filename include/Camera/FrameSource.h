@@ -0,0 +1,82 @@
+#ifndef __CAMERA__FRAMESOURCE__H__
+#define __CAMERA__FRAMESOURCE__H__
+
+#include <opencv/cv.h>
+#include <cstdlib>
+#include <string>
+
+namespace Camera
+{
+	/**
+	 * @brief	Delivers the BGR frames the capture works on.
+	 *			Every frame has a timestamp in milliseconds, so recorded footage can be replayed
+	 *			with the same timing on every run.
+	 * @see		CameraSource, VideoSource, V4L2Source
+	 * @author	Bas Stroosnijder
+	 */
+	class FrameSource
+	{
+	public:
+		/**
+		 * @brief	Destructor
+		 */
+		virtual ~FrameSource();
+
+		/**
+		 * @brief	Creates a frame source from a description.
+		 *			"camera" or "camera:<id>" opens a camera through OpenCV,
+		 *			"v4l2:<device>" opens a Video4Linux2 device on Linux,
+		 *			anything else is opened as a video file or an image sequence such as "frames/%04d.png".
+		 * @param	p_description The description of the source
+		 * @return	The new frame source, check IsOpened to see whether it could be opened
+		 */
+		static FrameSource* Create(std::string p_description);
+
+		/**
+		 * @brief	Whether frames can be read from the source
+		 * @return	Whether the source is opened
+		 */
+		virtual bool IsOpened() = 0;
+
+		/**
+		 * @brief	The size of the frames
+		 * @return	The size of the frames
+		 */
+		virtual cv::Size GetSize() = 0;
+
+		/**
+		 * @brief	Whether a new frame can be read without waiting for it.
+		 *			Sources that cannot tell always report a frame, Read may then block.
+		 * @return	Whether Read will return a frame right away
+		 */
+		virtual bool IsFrameReady();
+
+		/**
+		 * @brief	Switches the source to another frame size, frames that were already waiting may still have the old size.
+		 *			Sources that cannot switch keep their size.
+		 * @param	p_size The new size of the frames
+		 * @return	Whether the source delivers frames of p_size now
+		 */
+		virtual bool SetSize(cv::Size p_size);
+
+		/**
+		 * @brief	Reads the next frame
+		 * @param	p_image Receives the BGR frame, its buffer is reused when the size matches
+		 * @return	Whether a frame was read
+		 */
+		virtual bool Read(cv::Mat& p_image) = 0;
+
+		/**
+		 * @brief	The timestamp of the last frame that was read
+		 * @return	The timestamp in milliseconds
+		 */
+		virtual double GetTimestamp() = 0;
+
+		/**
+		 * @brief	Closes the source
+		 */
+		virtual void Release() = 0;
+	};
+}
+
+#endif
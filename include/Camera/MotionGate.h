@@ -0,0 +1,87 @@
+#ifndef __CAMERA__MOTIONGATE__H__
+#define __CAMERA__MOTIONGATE__H__
+
+#include <opencv/cv.h>
+#include <algorithm>
+
+namespace Camera
+{
+	/**
+	 * @brief	Tells whether anything changed in view since the last frame that was analyzed.
+	 *			Every frame is shrunk to a small grey thumbnail and compared with the thumbnail
+	 *			of the last analyzed frame. Differences below the noise level of the camera are ignored,
+	 *			the rest is summed; when the sum passes the threshold the scene has changed.
+	 *			Comparing with the last analyzed frame instead of the previous frame means slow changes
+	 *			add up until they are noticed. A refresh is forced every so many frames regardless.
+	 * @author	Bas Stroosnijder
+	 */
+	class MotionGate
+	{
+	public:
+		/**
+		 * @brief	Constructor
+		 */
+		MotionGate();
+
+		/**
+		 * @brief	Destructor
+		 */
+		~MotionGate();
+
+		/**
+		 * @brief	Compares a frame with the last analyzed frame. When it has changed
+		 *			the frame becomes the new last analyzed frame.
+		 * @param	p_image The BGR frame
+		 * @return	Whether the frame has to be analyzed
+		 */
+		bool HasChanged(const cv::Mat& p_image);
+
+		/**
+		 * @brief	Forgets the last analyzed frame, so the next frame is always analyzed
+		 */
+		void Reset();
+
+		/**
+		 * @brief	Sets the summed difference above which a frame counts as changed
+		 * @param	p_threshold The threshold in grey levels, 200 by default
+		 */
+		void SetThreshold(double p_threshold);
+
+		/**
+		 * @brief	Sets after how many unchanged frames a frame is analyzed anyway
+		 * @param	p_refreshInterval The number of frames, 30 by default
+		 */
+		void SetRefreshInterval(int p_refreshInterval);
+
+		/**
+		 * @brief	The summed difference of the last compared frame
+		 * @return	The difference in grey levels
+		 */
+		double GetLastDifference();
+
+		/**
+		 * @brief	The number of frames that did not have to be analyzed
+		 * @return	The number of skipped frames
+		 */
+		unsigned long GetSkippedCount();
+
+	private:
+		// The thumbnail is this many times smaller than the frame in both directions
+		static const int C_SCALE = 8;
+		// Thumbnail pixels that differ less than this are camera noise
+		static const int C_NOISE = 12;
+
+		cv::Mat m_scaled;
+		cv::Mat m_thumbnail;
+		cv::Mat m_reference;
+		cv::Mat m_difference;
+		bool m_hasReference;
+		int m_unchangedFrames;
+		int m_refreshInterval;
+		double m_threshold;
+		double m_lastDifference;
+		unsigned long m_skipped;
+	};
+}
+
+#endif
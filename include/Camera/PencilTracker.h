@@ -0,0 +1,141 @@
+#ifndef __CAMERA__PENCILTRACKER__H__
+#define __CAMERA__PENCILTRACKER__H__
+
+#include <irrlicht.h>
+#include <vector>
+#include <algorithm>
+
+namespace Camera
+{
+	/**
+	 * @brief	Follows the pencils that are found over the camera frames and decides when they lie still.
+	 *			A pencil that is found is matched to the pencil it was closest to in the frames before, with
+	 *			the ends swapped when that fits better. Every pencil keeps a vote per frame for the last
+	 *			C_WINDOW frames, whether it was found or not. The layout is stable once every pencil was
+	 *			clearly found or clearly missing in those frames; it is only handed out when it differs
+	 *			from the layout that was handed out before, so the path is built once per real change
+	 *			instead of once per frame.
+	 *			Distances are measured relative to the length of a pencil, so it works in any units.
+	 * @author	Bas Stroosnijder
+	 */
+	class PencilTracker
+	{
+	public:
+		/**
+		 * @brief	Constructor
+		 */
+		PencilTracker();
+
+		/**
+		 * @brief	Destructor
+		 */
+		~PencilTracker();
+
+		/**
+		 * @brief	Adds the pencils found in a camera frame
+		 * @param	p_startPoints One end of every pencil
+		 * @param	p_endPoints The other end of every pencil
+		 * @param	p_amount The number of pencils
+		 * @param	p_sequence The sequence number of the camera frame, a frame that was added before is ignored
+		 * @return	Whether a new stable layout can be taken with GetLayout
+		 */
+		bool Update(const irr::core::vector3df* p_startPoints, const irr::core::vector3df* p_endPoints, int p_amount, unsigned long p_sequence);
+
+		/**
+		 * @brief	Copies the last stable layout
+		 * @param	p_startPoints Receives a new array with one end of every pencil, delete[] it after use
+		 * @param	p_endPoints Receives a new array with the other end of every pencil, delete[] it after use
+		 * @return	The number of pencils, the arrays are left alone when it is 0
+		 */
+		int GetLayout(irr::core::vector3df*& p_startPoints, irr::core::vector3df*& p_endPoints);
+
+		/**
+		 * @brief	Forgets every pencil and the last layout, the next stable layout is handed out again
+		 */
+		void Reset();
+
+		/**
+		 * @brief	Sets how far a pencil may be from where it was and still be the same pencil
+		 * @param	p_ratio The distance of both ends together relative to the length of the pencil
+		 */
+		void SetMatchRatio(float p_ratio);
+
+		/**
+		 * @brief	Sets how far a pencil has to move before the layout counts as changed
+		 * @param	p_ratio The distance of both ends together relative to the length of the pencil
+		 */
+		void SetChangeRatio(float p_ratio);
+
+		/**
+		 * @brief	The number of frames that were added since the last reset
+		 * @return	The number of frames
+		 */
+		unsigned long GetFrameCount();
+
+		/**
+		 * @brief	The number of layouts that were handed out since the last reset
+		 * @return	The number of layouts
+		 */
+		unsigned long GetLayoutCount();
+
+	private:
+		// The number of frames a pencil is voted on
+		static const int C_WINDOW = 15;
+		// The number of frames in the window a pencil has to be found in to be part of the layout,
+		// or missing from to be left out of it
+		static const int C_MIN_VOTES = 10;
+
+		/**
+		 * @brief	A pencil that is followed over the frames
+		 */
+		struct Track
+		{
+			irr::core::vector3df m_start;
+			irr::core::vector3df m_end;
+			// A bit per frame, the lowest is the newest frame, set when the pencil was found in it
+			unsigned int m_votes;
+			// The number of frames the pencil was voted on, up to C_WINDOW
+			int m_frames;
+			bool m_matched;
+		};
+
+		std::vector<Track> m_tracks;
+		std::vector<irr::core::vector3df> m_layoutStarts;
+		std::vector<irr::core::vector3df> m_layoutEnds;
+		unsigned long m_sequence;
+		bool m_hasSequence;
+		float m_matchRatio;
+		float m_changeRatio;
+		unsigned long m_frames;
+		unsigned long m_layouts;
+
+		/**
+		 * @brief	Measures how far a pencil is from another
+		 * @param	p_start One end of the first pencil
+		 * @param	p_end The other end of the first pencil
+		 * @param	p_otherStart One end of the second pencil
+		 * @param	p_otherEnd The other end of the second pencil
+		 * @param	p_swapped Receives whether the ends of the second pencil are the other way around
+		 * @return	The distance of both ends together, relative to the length of the first pencil
+		 */
+		static float Distance(const irr::core::vector3df& p_start, const irr::core::vector3df& p_end,
+				const irr::core::vector3df& p_otherStart, const irr::core::vector3df& p_otherEnd, bool& p_swapped);
+
+		/**
+		 * @brief	Counts the frames in the window a pencil was found in
+		 * @param	p_votes The votes of the pencil
+		 * @return	The number of frames
+		 */
+		static int CountVotes(unsigned int p_votes);
+
+		/**
+		 * @brief	Whether the stable pencils differ from the last layout
+		 * @param	p_starts One end of every stable pencil
+		 * @param	p_ends The other end of every stable pencil
+		 * @return	Whether the layout changed
+		 */
+		bool HasChanged(const std::vector<irr::core::vector3df>& p_starts, const std::vector<irr::core::vector3df>& p_ends);
+	};
+}
+
+#endif
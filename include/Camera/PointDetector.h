@@ -1,11 +1,19 @@
 #ifndef __CAMERA__POINTDETECTOR__H__
 #define __CAMERA__POINTDETECTOR__H__
 
+#include "CalibrationParams.h"
+#include "DetectionWorkspace.h"
+#include "DebugOverlay.h"
+#include "Utility/ProfileScope.h"
+#include "Utility/Logger.h"
 #include <opencv/cv.h>
 #include <opencv/highgui.h>
 #include <irrlicht.h>
 #include <vector>
 #include <list>
+#include <cmath>
+#include <algorithm>
+#include <cstring>
 
 namespace Camera
 {
@@ -18,8 +26,9 @@ namespace Camera
 	public:
 		/**
 		* @brief	Constructor
+		* @param	p_params The calibration parameters used to undistort the detected points
 		*/
-		PointDetector(void);
+		PointDetector(CalibrationParams* p_params);
 
 		/**
 		* @brief	Destructor
@@ -29,7 +38,7 @@ namespace Camera
 		/**
 		* @brief	Finds start and end points of path markers in a frame and sets the m_startPoints and m_endPoints point arrays
 		* @param	p_frame The frame to capture points in
-		* @param	p_corners Determines the rotation of the frame
+		* @param	p_corners Determines the rotation of the frame, in the coordinates of p_frame
 		* @param	p_cameraMatrix The camera matrix for multiplying with the points.
 		* @param	p_startPoints A pointer to a vector3df array to store start points.
 		* @param	p_endPoints A pointer to a vector3df array to store end points.
@@ -40,6 +49,228 @@ namespace Camera
 				float p_pixelDistance, cv::Size p_sizeHalfed, 
 				irr::core::vector3df*& p_startPoints, 
 				irr::core::vector3df*& p_endPoints);
+
+		/**
+		* @brief	Sets whether the frames are distorted and only the detected points should be undistorted
+		* @param	p_undistortPoints Whether to undistort the detected points
+		*/
+		void SetUndistortPoints(bool p_undistortPoints);
+
+		/**
+		* @brief	Sets whether the detected points are added to the DebugOverlay while it is enabled. Enabled by default.
+		* @param	p_debugOutput Whether to show the debug output
+		*/
+		void SetDebugOutput(bool p_debugOutput);
+
+		/**
+		* @brief	The number of detections that had to allocate scratch memory, stays the same once warmed up
+		* @return	The number of detections with a reallocation
+		*/
+		unsigned long GetReallocationCount();
+
+		/**
+		* @brief	The number of blobs of the right size that were not shaped like a pencil
+		* @return	The number of rejected blobs
+		*/
+		unsigned long GetRejectedCount();
+
+		/**
+		* @brief	The number of searches that could reuse the transformation of the search before
+		* @return	The number of reused transformations
+		*/
+		unsigned long GetReusedRectificationCount();
+
+		/**
+		* @brief	Sets whether only the part of the frame around the board is rectified, into a quad
+		*			that is about as large as the board is on screen. Otherwise the whole frame is handed to
+		*			the warp and the quad is always C_QUAD_SIZE. Enabled by default.
+		* @param	p_croppedRectification Whether to crop the frame and size the quad to the board
+		*/
+		void SetCroppedRectification(bool p_croppedRectification);
+
+		/**
+		* @brief	Sets whether only the tiles of the quad that changed since the last search are thresholded and
+		*			searched again, together with the tiles around them. The blobs in the rest of the quad are kept
+		*			from the search before. Gives the same pencils as searching the whole quad. Enabled by default.
+		* @param	p_incremental Whether to search only the tiles that changed
+		*/
+		void SetIncremental(bool p_incremental);
+
+		/**
+		* @brief	Sets whether every incremental search is checked against a search of the whole quad,
+		*			a difference is logged. Costs more than searching the whole quad, only meant for testing.
+		* @param	p_checkIncremental Whether to check the incremental searches
+		*/
+		void SetCheckIncremental(bool p_checkIncremental);
+
+		/**
+		* @brief	The number of searches that only searched the tiles that changed
+		* @return	The number of incremental searches
+		*/
+		unsigned long GetIncrementalCount();
+
+		/**
+		* @brief	The number of incremental searches that differed from a search of the whole quad
+		* @return	The number of differences, only counted while checking
+		*/
+		unsigned long GetIncrementalMismatchCount();
+
+	private:
+		/**
+		* @brief	A contour that was found in the quad, with the ends when it is a pencil
+		*/
+		struct Blob
+		{
+			// The pixels the contour covers in the black & white image
+			cv::Rect m_bounds;
+			// The point the contour starts at, gives the order of the image
+			cv::Point m_first;
+			bool m_pencil;
+			cv::Point2f m_pointA;
+			cv::Point2f m_pointB;
+		};
+
+		// The size of the tiles the quad is compared in, in pixels
+		static const int C_TILE_SIZE = 32;
+		// The size of the quad the sizes of the pencils are measured in, and the largest quad
+		static const int C_QUAD_SIZE = 300;
+		// The smallest quad, pencils get too thin to find below it
+		static const int C_MIN_QUAD_SIZE = 120;
+		// The quad grows and shrinks in steps, so a board that jitters keeps the same quad size
+		static const int C_QUAD_STEP = 20;
+		// The area of a pencil in the quad, in pixels
+		static const int C_MIN_AREA = 100;
+		static const int C_MAX_AREA = 1000;
+		// How many times longer than wide a pencil is at least
+		static const int C_MIN_ELONGATION = 2;
+		// The shortest distance between the ends of a pencil, in pixels
+		static const int C_MIN_LENGTH = 10;
+
+		CalibrationParams* m_params;
+		Utility::LatencyHistogram* m_histogram;
+		bool m_undistortPoints;
+		bool m_debugOutput;
+		DetectionWorkspace* m_workspace;
+		cv::Size m_quadSize;
+		// The size of the frame that is searched, the camera may not run at the calibrated size
+		cv::Size m_frameSize;
+		std::vector<cv::Point2f> m_quadPoints;
+		bool m_croppedRectification;
+		// How far a corner may move before the transformation is made again, in pixels
+		float m_cornerEpsilon;
+		// What the transformation was made for
+		std::vector<cv::Point2f> m_rectifiedCorners;
+		cv::Size m_rectifiedFrameSize;
+		bool m_rectifiedUndistorted;
+		bool m_rectifiedCropped;
+		cv::Rect m_region;
+		cv::Mat m_warpMatrix;
+		// From the quad back to the frame
+		cv::Mat m_quadToFrame;
+		cv::Mat m_inverseMatrix;
+		cv::Mat m_undistortedMatrix;
+		unsigned long m_reusedRectifications;
+		bool m_incremental;
+		bool m_checkIncremental;
+		// The grey quad of this search and the one before, and the black & white image that belongs to the last one
+		cv::Mat m_gray;
+		cv::Mat m_lastGray;
+		cv::Mat m_binary;
+		bool m_hasBinary;
+		// A flag per tile of which the black & white image changed, row by row
+		std::vector<unsigned char> m_dirtyTiles;
+		int m_tileColumns;
+		// Every contour in the black & white image in the order of the image, and the ones found again
+		std::vector<Blob> m_blobs;
+		std::vector<Blob> m_scannedBlobs;
+		unsigned long m_incrementalScans;
+		unsigned long m_incrementalMismatches;
+		// The ends of the pencils in the quad, kept so their memory is reused
+		std::vector<cv::Point2f> m_pencilStarts;
+		std::vector<cv::Point2f> m_pencilEnds;
+		unsigned long m_rejectedBlobs;
+
+		/**
+		* @brief	Finds the ends of a pencil from the moments of its contour.
+		*			The axis follows from the second-order central moments, the ends are the
+		*			points of the contour that lie furthest along it on either side of the center.
+		* @param	p_contour The contour in the quad
+		* @param	p_scale The size of the quad divided by C_QUAD_SIZE
+		* @param	p_pointA Receives one end
+		* @param	p_pointB Receives the other end
+		* @return	Whether the contour has the size and the shape of a pencil
+		*/
+		bool FindEnds(const cv::Mat& p_contour, float p_scale, cv::Point2f& p_pointA, cv::Point2f& p_pointB);
+
+		/**
+		* @brief	Adds the ends and the bounding boxes of the pencils that were found to the DebugOverlay, in the frame
+		* @param	p_offset The offset that was added to the points of the contours
+		*/
+		void ShowPencils(cv::Point p_offset);
+
+		/**
+		* @brief	Thresholds the tiles of which the grey image changed since the last search and marks the tiles
+		*			of which the black & white image changed with it
+		* @return	Whether any of the black & white image changed
+		*/
+		bool ThresholdChangedTiles();
+
+		/**
+		* @brief	Finds the blobs around the changed tiles again and keeps the others
+		* @param	p_scale The size of the quad divided by C_QUAD_SIZE
+		* @param	p_offset The offset added to the points of the contours
+		*/
+		void UpdateBlobs(float p_scale, cv::Point p_offset);
+
+		/**
+		* @brief	Finds the blobs in a region of the black & white image
+		* @param	p_region The region to search
+		* @param	p_scale The size of the quad divided by C_QUAD_SIZE
+		* @param	p_offset The offset added to the points of the contours
+		* @param	p_blobs Receives the blobs, only when every blob lies within the region
+		* @return	p_region when every blob lies within it, otherwise a larger region to search instead
+		*/
+		cv::Rect ScanRegion(cv::Rect p_region, float p_scale, cv::Point p_offset, std::vector<Blob>& p_blobs);
+
+		/**
+		* @brief	Compares the pixels of two images of the same size and type
+		* @param	p_first The first image
+		* @param	p_second The second image
+		* @return	Whether every pixel is the same
+		*/
+		static bool IsSame(const cv::Mat& p_first, const cv::Mat& p_second);
+
+		/**
+		* @brief	Compares two sorted lists of blobs
+		* @param	p_first The first list
+		* @param	p_second The second list
+		* @return	Whether both have the same blobs with the same ends
+		*/
+		static bool IsSamePencils(const std::vector<Blob>& p_first, const std::vector<Blob>& p_second);
+
+		/**
+		* @brief	Orders blobs by the point their contour starts at, row by row
+		* @param	p_first The first blob
+		* @param	p_second The second blob
+		* @return	Whether p_first comes before p_second
+		*/
+		static bool CompareBlobs(const Blob& p_first, const Blob& p_second);
+
+		/**
+		* @brief	Makes the transformation from the frame to the quad again when the corners moved further
+		*			than the epsilon, the frame changed size or the rectification settings changed
+		* @param	p_corners The corners of the board in the frame
+		*/
+		void UpdateRectification(const std::vector<cv::Point2f>& p_corners);
+
+		/**
+		* @brief	Moves points found in the distorted quad to where they are in the undistorted quad
+		* @param	p_points The points in the distorted quad
+		* @param	p_inverseMatrix Transformation from the distorted quad to the distorted frame
+		* @param	p_undistortedMatrix Transformation from the undistorted frame to the undistorted quad
+		*/
+		void UndistortQuadPoints(std::vector<cv::Point2f>& p_points,
+				cv::Mat p_inverseMatrix, cv::Mat p_undistortedMatrix);
 	};
 
 }
@@ -0,0 +1,84 @@
+#ifndef __CAMERA__POSEESTIMATOR__H__
+#define __CAMERA__POSEESTIMATOR__H__
+
+#include "CalibrationParams.h"
+#include <irrlicht.h>
+#include <opencv/cv.h>
+#include <vector>
+
+namespace Camera
+{
+	/**
+	 * @brief	Estimates the pose of the playing surface relative to the camera from its four corners.
+	 *			The corners are matched against a flat model of the playground with cv::solvePnP using
+	 *			the calibrated intrinsics. Every estimate starts from the previous pose, so a surface that
+	 *			barely moves converges in a couple of iterations instead of starting over.
+	 *			The result is expressed in Irrlicht view space, ready to be placed in the scene.
+	 * @author	Bas Stroosnijder
+	 */
+	class PoseEstimator
+	{
+	public:
+		/**
+		 * @brief	Constructor
+		 * @param	p_params The calibration parameters to take the camera matrix from
+		 */
+		PoseEstimator(CalibrationParams* p_params);
+
+		/**
+		 * @brief	Destructor
+		 */
+		~PoseEstimator();
+
+		/**
+		 * @brief	Estimates the pose of the playground from its corners.
+		 *			The playground starts in the top left corner and lies in its local xz-plane,
+		 *			the top edge runs along -z and the right edge along -x.
+		 * @param	p_corners The four sorted and undistorted corners in frame coordinates
+		 * @param	p_height The length of the top edge of the playground in game units
+		 * @param	p_length The length of the right edge of the playground in game units
+		 * @param	p_pose Receives the matrix that moves the playground into Irrlicht view space
+		 * @return	Whether a pose could be estimated, p_pose is left untouched when it could not
+		 */
+		bool Estimate(const std::vector<cv::Point2f>& p_corners, float p_height, float p_length, irr::core::matrix4& p_pose);
+
+		/**
+		 * @brief	Forgets the previous pose, the next estimate starts from scratch
+		 */
+		void Reset();
+
+		/**
+		 * @brief	Sets the largest mean reprojection error a pose may have before it is rejected
+		 * @param	p_maxError The maximum error in pixels
+		 */
+		void SetMaxError(float p_maxError);
+
+		/**
+		 * @brief	Sets the size of the frames the corners come from, when it is not the calibrated size
+		 * @param	p_size The size of the frames
+		 */
+		void SetFrameSize(cv::Size p_size);
+
+		/**
+		 * @brief	The mean distance between the corners and the reprojected model of the last estimate
+		 * @return	The reprojection error in pixels
+		 */
+		float GetLastError();
+
+	private:
+		CalibrationParams* m_params;
+		std::vector<cv::Point3f> m_objectPoints;
+		std::vector<cv::Point2f> m_projectedPoints;
+		cv::Mat m_cameraMatrix;
+		cv::Size m_frameSize;
+		cv::Mat m_distortion;
+		cv::Mat m_rotationVector;
+		cv::Mat m_translationVector;
+		cv::Mat m_rotation;
+		bool m_hasPose;
+		float m_maxError;
+		float m_lastError;
+	};
+}
+
+#endif
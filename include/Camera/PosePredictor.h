@@ -0,0 +1,123 @@
+#ifndef __CAMERA__POSEPREDICTOR__H__
+#define __CAMERA__POSEPREDICTOR__H__
+
+#include <irrlicht.h>
+#include <opencv/cv.h>
+#include <cmath>
+
+namespace Camera
+{
+	/**
+	 * @brief	Smooths the pose of the playground over time and estimates how fast it moves,
+	 *			so the pose can be moved ahead to the moment the frame is actually on screen.
+	 *			Translation and rotation both go through a One-Euro filter: while the playground
+	 *			stands still the cut-off frequency is low and the jitter of the detection is removed,
+	 *			when it moves the cut-off goes up with the speed so the pose does not lag behind.
+	 *			Rotations are filtered as rotation vectors between the filtered and the new pose.
+	 *			The poses are expected to be rigid, any scale in them is lost.
+	 * @author	Bas Stroosnijder
+	 */
+	class PosePredictor
+	{
+	public:
+		/**
+		 * @brief	Constructor
+		 */
+		PosePredictor();
+
+		/**
+		 * @brief	Destructor
+		 */
+		~PosePredictor();
+
+		/**
+		 * @brief	Adds a new measured pose to the filter
+		 * @param	p_pose The measured pose
+		 * @param	p_time When the frame of the pose was acquired, in seconds
+		 * @return	The filtered pose
+		 */
+		irr::core::matrix4 Update(const irr::core::matrix4& p_pose, double p_time);
+
+		/**
+		 * @brief	Forgets the pose, the next pose is taken over without filtering
+		 */
+		void Reset();
+
+		/**
+		 * @brief	The last filtered pose
+		 * @return	The filtered pose
+		 */
+		irr::core::matrix4 GetPose();
+
+		/**
+		 * @brief	The filtered speed of the translation
+		 * @return	The velocity in units per second
+		 */
+		irr::core::vector3df GetVelocity();
+
+		/**
+		 * @brief	The filtered speed of the rotation
+		 * @return	The rotation axis in world space, its length in radians per second
+		 */
+		cv::Vec3d GetAngularVelocity();
+
+		/**
+		 * @brief	Sets how much the pose is smoothed while it stands still
+		 * @param	p_minCutoff The cut-off frequency in Hz, 1 by default
+		 */
+		void SetMinCutoff(double p_minCutoff);
+
+		/**
+		 * @brief	Sets how fast the cut-off frequency rises with the speed of the pose
+		 * @param	p_translationBeta Hz per unit per second, 0.01 by default
+		 * @param	p_rotationBeta Hz per radian per second, 2 by default
+		 */
+		void SetBeta(double p_translationBeta, double p_rotationBeta);
+
+		/**
+		 * @brief	Moves a pose ahead in time at a constant velocity
+		 * @param	p_pose The pose to move
+		 * @param	p_velocity The velocity in units per second
+		 * @param	p_angularVelocity The angular velocity in radians per second
+		 * @param	p_seconds How far to move ahead
+		 * @return	The pose after p_seconds
+		 */
+		static irr::core::matrix4 Extrapolate(const irr::core::matrix4& p_pose, const irr::core::vector3df& p_velocity, const cv::Vec3d& p_angularVelocity, double p_seconds);
+
+	private:
+		bool m_hasPose;
+		double m_time;
+		irr::core::vector3df m_translation;
+		irr::core::vector3df m_velocity;
+		cv::Matx33d m_rotation;
+		cv::Vec3d m_angularVelocity;
+		double m_minCutoff;
+		double m_derivativeCutoff;
+		double m_translationBeta;
+		double m_rotationBeta;
+
+		/**
+		 * @brief	The weight of a new sample in a low-pass filter
+		 * @param	p_cutoff The cut-off frequency in Hz
+		 * @param	p_interval The time since the last sample in seconds
+		 * @return	The weight between 0 and 1
+		 */
+		static double GetAlpha(double p_cutoff, double p_interval);
+
+		/**
+		 * @brief	Takes the rotation out of an Irrlicht matrix
+		 * @param	p_matrix The matrix
+		 * @return	The rotation as a matrix that rotates column vectors
+		 */
+		static cv::Matx33d GetRotation(const irr::core::matrix4& p_matrix);
+
+		/**
+		 * @brief	Puts a rotation into an Irrlicht matrix, the translation is left alone
+		 * @param	p_matrix The matrix to change
+		 * @param	p_rotation The rotation as a matrix that rotates column vectors
+		 */
+		static void SetRotation(irr::core::matrix4& p_matrix, const cv::Matx33d& p_rotation);
+	};
+}
+
+#endif
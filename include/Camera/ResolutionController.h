@@ -0,0 +1,134 @@
+#ifndef __CAMERA__RESOLUTIONCONTROLLER__H__
+#define __CAMERA__RESOLUTIONCONTROLLER__H__
+
+#include <opencv/cv.h>
+#include <algorithm>
+#include <vector>
+
+namespace Camera
+{
+	/**
+	 * @brief	Keeps the detection of the surface within a time budget by lowering the resolution it works at.
+	 *			The detection time of every frame is averaged; when the average stays over the budget the
+	 *			surface is first searched at a coarser detection scale, and only when that is as coarse as
+	 *			it gets the camera is switched to a smaller mode. When the average stays well below the budget
+	 *			the steps are taken back in the opposite order, so the camera returns to full size first.
+	 *			Both directions need the average to stay over or under for a while, and every step is
+	 *			followed by a few frames in which nothing is measured, so the controller does not oscillate.
+	 * @author	Bas Stroosnijder
+	 */
+	class ResolutionController
+	{
+	public:
+		/**
+		 * @brief	Constructor
+		 * @param	p_modes The camera modes from large to small, the first one is used at the start
+		 * @param	p_scale The finest detection scale, used at the start
+		 */
+		ResolutionController(const std::vector<cv::Size>& p_modes, int p_scale);
+
+		/**
+		 * @brief	Destructor
+		 */
+		~ResolutionController();
+
+		/**
+		 * @brief	Adds the detection time of a frame
+		 * @param	p_milliseconds How long the detection took
+		 * @return	Whether the mode or the detection scale changed
+		 */
+		bool Update(double p_milliseconds);
+
+		/**
+		 * @brief	Sets how long the detection of a frame may take
+		 * @param	p_milliseconds The budget, 25 ms by default
+		 */
+		void SetBudget(double p_milliseconds);
+
+		/**
+		 * @brief	Replaces the camera modes, the largest mode is used again
+		 * @param	p_modes The camera modes from large to small
+		 */
+		void SetModes(const std::vector<cv::Size>& p_modes);
+
+		/**
+		 * @brief	Sets the finest detection scale, the controller only makes it coarser
+		 * @param	p_scale The finest scale
+		 */
+		void SetMinScale(int p_scale);
+
+		/**
+		 * @brief	The number of camera modes the controller can choose from
+		 * @return	The number of modes
+		 */
+		int GetModeCount();
+
+		/**
+		 * @brief	The camera mode to use
+		 * @return	The size of the frames
+		 */
+		cv::Size GetMode();
+
+		/**
+		 * @brief	The detection scale to use
+		 * @return	How many times smaller the surface is searched
+		 */
+		int GetScale();
+
+		/**
+		 * @brief	The average detection time
+		 * @return	The average in milliseconds
+		 */
+		double GetAverage();
+
+		/**
+		 * @brief	The number of times the resolution was lowered
+		 * @return	The number of steps down
+		 */
+		unsigned long GetStepDownCount();
+
+		/**
+		 * @brief	The number of times the resolution was raised
+		 * @return	The number of steps up
+		 */
+		unsigned long GetStepUpCount();
+
+	private:
+		// The coarsest detection scale, the surface is then no more than a few dozen pixels wide
+		static const int C_MAX_SCALE = 8;
+		// Frames the average has to be over the budget before stepping down
+		static const int C_OVER_FRAMES = 10;
+		// Frames the average has to be under the headroom before stepping up
+		static const int C_UNDER_FRAMES = 90;
+		// Frames that are not measured after a step, the camera needs some to switch
+		static const int C_SETTLE_FRAMES = 15;
+
+		std::vector<cv::Size> m_modes;
+		int m_mode;
+		int m_scale;
+		int m_minScale;
+		double m_budget;
+		// Halving the resolution roughly quarters the time, so stepping up waits for plenty of room
+		double m_headroom;
+		double m_average;
+		int m_overFrames;
+		int m_underFrames;
+		int m_settleFrames;
+		unsigned long m_stepsDown;
+		unsigned long m_stepsUp;
+
+		/**
+		 * @brief	Lowers the resolution one step
+		 * @return	Whether there was a step left
+		 */
+		bool StepDown();
+
+		/**
+		 * @brief	Raises the resolution one step
+		 * @return	Whether there was a step left
+		 */
+		bool StepUp();
+	};
+}
+
+#endif
@@ -0,0 +1,208 @@
+#ifndef __CAMERA__SHAREDFRAMERING__H__
+#define __CAMERA__SHAREDFRAMERING__H__
+
+#include "Frame.h"
+#include "Utility/Logger.h"
+#include <opencv/cv.h>
+#include <atomic>
+#include <string>
+#include <cstring>
+
+namespace Camera
+{
+	/**
+	 * @brief	Ring of camera frames in shared memory, so tools in other processes can watch the rectified
+	 *			stream together with the corners and the pose of the surface.
+	 *			One process creates the ring and publishes into it, any number of processes open it to read.
+	 *			Every slot is guarded by a version that is odd while the slot is written. A reader looks at the
+	 *			pixels in place and checks afterwards whether the version is still the same, so the writer never
+	 *			waits for anyone; a reader that was too slow simply has to drop the frame and take the newest one.
+	 *			Uses POSIX shared memory, or a named file mapping on Windows.
+	 *
+	 *			Reading:
+	 *			int slot = ring.GetLatestSlot();
+	 *			if (slot >= 0 && ring.BeginRead(slot, info, image, version))
+	 *			{
+	 *				... use info and image ...
+	 *				if (!ring.EndRead(slot, version)) { the frame was overwritten, drop the results }
+	 *			}
+	 * @author	Bas Stroosnijder
+	 */
+	class SharedFrameRing
+	{
+	public:
+		/**
+		 * @brief	Everything about a frame except its pixels, laid out the same in every process
+		 */
+		struct FrameInfo
+		{
+			unsigned long long m_sequence;
+			// When the frame source delivered the image, in milliseconds
+			double m_timestamp;
+			int m_width;
+			int m_height;
+			int m_type;
+			int m_step;
+			int m_lost;
+			// Top left, top right, bottom right and bottom left as x, y pairs in frame coordinates
+			float m_corners[8];
+			float m_pixelDistance;
+			float m_lineRatio;
+			// The Irrlicht transform matrix of the playground
+			float m_transformation[16];
+		};
+
+		/**
+		 * @brief	Constructor
+		 */
+		SharedFrameRing();
+
+		/**
+		 * @brief	Destructor, closes the ring
+		 */
+		~SharedFrameRing();
+
+		/**
+		 * @brief	Creates the ring to publish into, a ring that was left behind under the same name is replaced
+		 * @param	p_name The name other processes open the ring with
+		 * @param	p_slotCount The number of frames in the ring
+		 * @param	p_imageCapacity The largest image in bytes
+		 * @return	Whether the ring was created
+		 */
+		bool Create(const std::string& p_name, int p_slotCount, size_t p_imageCapacity);
+
+		/**
+		 * @brief	Opens a ring another process created, only to read from
+		 * @param	p_name The name of the ring
+		 * @return	Whether the ring was opened
+		 */
+		bool Open(const std::string& p_name);
+
+		/**
+		 * @brief	Unmaps the ring, the creator also removes its name
+		 */
+		void Close();
+
+		/**
+		 * @brief	Whether the ring was created or opened
+		 * @return	Whether the ring can be used
+		 */
+		bool IsOpened();
+
+		/**
+		 * @brief	Copies a frame into the oldest slot. Never waits for readers.
+		 *			Only the creator may publish, from one thread at a time.
+		 * @param	p_frame The frame to publish
+		 * @return	Whether the frame fit in the ring
+		 */
+		bool Publish(const Frame& p_frame);
+
+		/**
+		 * @brief	The slot of the newest published frame
+		 * @return	The slot, -1 when nothing was published yet
+		 */
+		int GetLatestSlot();
+
+		/**
+		 * @brief	Starts reading a slot
+		 * @param	p_slot The slot to read
+		 * @param	p_info Receives the information of the frame
+		 * @param	p_image Receives a header on the pixels in shared memory, nothing is copied
+		 * @param	p_version Receives the version to pass to EndRead
+		 * @return	Whether the slot holds a frame that is not being written
+		 */
+		bool BeginRead(int p_slot, FrameInfo& p_info, cv::Mat& p_image, unsigned int& p_version);
+
+		/**
+		 * @brief	Finishes reading a slot
+		 * @param	p_slot The slot that was read
+		 * @param	p_version The version BeginRead gave
+		 * @return	Whether the slot stayed the same while it was read; if not, anything read from it is garbage
+		 */
+		bool EndRead(int p_slot, unsigned int p_version);
+
+		/**
+		 * @brief	The number of frames that were published into the ring
+		 * @return	The number of frames
+		 */
+		unsigned long GetPublishedCount();
+
+		/**
+		 * @brief	The number of frames that were too large for the ring
+		 * @return	The number of frames
+		 */
+		unsigned long GetOversizedCount();
+
+	private:
+		static const unsigned int C_MAGIC = 0x4B423036;
+		static const unsigned int C_VERSION = 1;
+		static const unsigned int C_NO_SLOT = 0xFFFFFFFF;
+		// Slots and images start on a cache line, so readers of one slot do not slow down the writer of the next
+		static const size_t C_ALIGNMENT = 64;
+
+		/**
+		 * @brief	The start of the shared memory
+		 */
+		struct Header
+		{
+			unsigned int m_magic;
+			unsigned int m_version;
+			unsigned int m_slotCount;
+			unsigned int m_slotSize;
+			unsigned int m_imageCapacity;
+			std::atomic<unsigned int> m_latest;
+			std::atomic<unsigned int> m_published;
+		};
+
+		/**
+		 * @brief	The start of every slot, the pixels follow after the alignment
+		 */
+		struct Slot
+		{
+			std::atomic<unsigned int> m_version;
+			FrameInfo m_info;
+		};
+
+		std::string m_name;
+		bool m_owner;
+		unsigned char* m_memory;
+		size_t m_size;
+		// The file mapping on Windows, the shared memory descriptor elsewhere
+		void* m_mapping;
+		int m_descriptor;
+		Header* m_header;
+		unsigned int m_next;
+		unsigned long m_oversized;
+
+		/**
+		 * @brief	Maps the shared memory
+		 * @param	p_size The size to map, 0 to take the size of an existing ring
+		 * @param	p_create Whether to create the shared memory
+		 * @return	Whether it was mapped
+		 */
+		bool Map(size_t p_size, bool p_create);
+
+		/**
+		 * @brief	Gets a slot
+		 * @param	p_slot The index of the slot
+		 * @return	The slot
+		 */
+		Slot* GetSlot(unsigned int p_slot);
+
+		/**
+		 * @brief	Gets the pixels of a slot
+		 * @param	p_slot The index of the slot
+		 * @return	The first byte of the image
+		 */
+		unsigned char* GetImage(unsigned int p_slot);
+
+		/**
+		 * @brief	Rounds a size up to the alignment
+		 * @param	p_size The size
+		 * @return	The aligned size
+		 */
+		static size_t Align(size_t p_size);
+	};
+}
+
+#endif
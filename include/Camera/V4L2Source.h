@@ -0,0 +1,85 @@
+#ifndef __CAMERA__V4L2SOURCE__H__
+#define __CAMERA__V4L2SOURCE__H__
+
+#ifdef __linux__
+
+#include "FrameSource.h"
+#include "Utility/Logger.h"
+#include <linux/videodev2.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace Camera
+{
+	/**
+	 * @brief	Reads frames from a Video4Linux2 device through memory mapped driver buffers.
+	 *			The driver writes straight into the mapped buffers and the YUYV data is converted
+	 *			to BGR directly from there, so no copy of the raw frame is ever made.
+	 *			A buffer is given back to the driver on the next Read.
+	 * @author	Bas Stroosnijder
+	 */
+	class V4L2Source : public FrameSource
+	{
+	public:
+		/**
+		 * @brief	Constructor
+		 * @param	p_device The device, for example /dev/video0
+		 * @param	p_size The requested frame size, the driver may choose the nearest size it supports
+		 */
+		V4L2Source(std::string p_device, cv::Size p_size = cv::Size(640, 480));
+
+		/**
+		 * @brief	Destructor
+		 */
+		~V4L2Source();
+
+		bool IsOpened();
+		cv::Size GetSize();
+		bool IsFrameReady();
+		bool Read(cv::Mat& p_image);
+		double GetTimestamp();
+		void Release();
+
+	private:
+		/**
+		 * @brief	A driver buffer mapped into our memory
+		 */
+		struct Buffer
+		{
+			void* m_start;
+			size_t m_length;
+		};
+
+		int m_fd;
+		std::vector<Buffer> m_buffers;
+		// The buffer that is still held from the previous Read, -1 if none
+		int m_held;
+		cv::Size m_size;
+		int m_bytesPerLine;
+		double m_timestamp;
+
+		/**
+		 * @brief	Sets the format, maps the buffers and starts streaming
+		 * @param	p_size The requested frame size
+		 * @return	Whether the device is streaming
+		 */
+		bool Open(cv::Size p_size);
+
+		/**
+		 * @brief	Logs a failed device call together with the error of the system
+		 * @param	p_call The name of the call
+		 */
+		void LogError(const char* p_call);
+	};
+}
+
+#endif
+
+#endif
@@ -0,0 +1,77 @@
+#ifndef __CAMERA__VIDEOSOURCE__H__
+#define __CAMERA__VIDEOSOURCE__H__
+
+#include "FrameSource.h"
+#include <opencv/highgui.h>
+#include <thread>
+#include <chrono>
+
+namespace Camera
+{
+	/**
+	 * @brief	Replays a recorded video or an image sequence.
+	 *			The timestamps follow from the frame number and the frame rate, not from the clock,
+	 *			so every run sees exactly the same frames with exactly the same timestamps.
+	 * @author	Bas Stroosnijder
+	 */
+	class VideoSource : public FrameSource
+	{
+	public:
+		/**
+		 * @brief	Constructor
+		 * @param	p_fileName The video file, or an image sequence pattern such as "frames/%04d.png"
+		 */
+		VideoSource(std::string p_fileName);
+
+		/**
+		 * @brief	Destructor
+		 */
+		~VideoSource();
+
+		bool IsOpened();
+		cv::Size GetSize();
+		bool IsFrameReady();
+		bool Read(cv::Mat& p_image);
+		double GetTimestamp();
+		void Release();
+
+		/**
+		 * @brief	Sets whether the recording starts over when it ends. Enabled by default.
+		 * @param	p_loop Whether to loop
+		 */
+		void SetLoop(bool p_loop);
+
+		/**
+		 * @brief	Sets whether Read waits until a frame is due, so the recording plays at its own frame rate.
+		 *			Disabled by default, frames are then handed out as fast as they are read.
+		 *			When paced, IsFrameReady only reports a frame once it is due.
+		 * @param	p_paced Whether to play at the recorded frame rate
+		 */
+		void SetPaced(bool p_paced);
+
+		/**
+		 * @brief	Sets the frame rate used for the timestamps, for image sequences and videos without one
+		 * @param	p_fps The number of frames per second
+		 */
+		void SetFps(double p_fps);
+
+		/**
+		 * @brief	The number of frames read since the source was opened, including loops
+		 * @return	The number of frames
+		 */
+		unsigned long GetFrameCount();
+
+	private:
+		std::string m_fileName;
+		cv::VideoCapture m_capture;
+		cv::Size m_size;
+		double m_fps;
+		bool m_loop;
+		bool m_paced;
+		unsigned long m_frameCount;
+		double m_timestamp;
+		std::chrono::steady_clock::time_point m_start;
+	};
+}
+
+#endif
@@ -10,6 +10,7 @@
 #include "DeltaTimer.h"
 #include "EventHandler.h"
 #include "Utility/Logger.h"
+#include "Camera/DebugOverlay.h"
 
 #include <irrlicht.h>
 
@@ -55,10 +56,12 @@ namespace Game
 		irr::IEventReceiver* GetEventReceiver();
 
 	   /**
-	    * @brief	Adds the captured image of the camera to the video driver and returns it as a texture
-		* @return	Returns an irrlicht ITexture object containing the captured image of the camera
+	    * @brief	Adds a texture for the captured image of the camera to the video driver
+		* @param	p_size	The size of the images the camera captures
+		* @param	p_index	Which of the textures the camera alternates between
+		* @return	Returns an irrlicht ITexture object for the captured image of the camera
 		*/
-		irr::video::ITexture* GetCameraTexture();
+		irr::video::ITexture* GetCameraTexture(irr::core::dimension2du p_size, int p_index);
 
 	   /**
 	    * @brief	Sets the vertical position of the camera
@@ -87,8 +90,15 @@ namespace Game
 
 	   /**
 	    * @brief	Draws the texture of captured image of the camera to the screen
+		* @param	p_texture	The texture with the newest image, nothing is drawn when it is NULL
 		*/
-		void DrawCameraTexture();
+		void DrawCameraTexture(irr::video::ITexture* p_texture);
+
+	   /**
+	    * @brief	Draws the primitives of the debug overlay over the screen, at the place of the camera image
+		* @param	p_primitives	The primitives to draw
+		*/
+		void DrawDebugOverlay(const std::vector<Camera::DebugOverlay::Primitive>& p_primitives);
 
 	   /**
 	    * @brief	Gets the projection matrix
@@ -2,6 +2,7 @@
 #define __GUI__H__
 
 #include "PlayerType.h"
+#include "Utility/Profiler.h"
 
 #include <irrlicht.h>
 #include <iostream>
@@ -88,6 +89,22 @@ namespace Game
 		 */
 		void HideControlsMenu();
 
+		/**
+		 * @brief	Shows the latency of every profiled stage in the top left corner and enables the Profiler.
+		 */
+		void ShowProfilerOverlay();
+
+		/**
+		 * @brief	Hides the profiler overlay, the Profiler keeps measuring.
+		 */
+		void HideProfilerOverlay();
+
+		/**
+		 * @brief	Whether the profiler overlay is shown.
+		 * @return	Whether the profiler overlay is shown
+		 */
+		bool IsProfilerOverlayVisible();
+
 		/**
 		 * @brief	Show the victory image for the defending player.
 		 *
@@ -166,6 +183,8 @@ namespace Game
 		irr::gui::IGUIStaticText* m_textFps;
 		irr::gui::IGUIStaticText* m_textPlayer1Points;
 		irr::gui::IGUIStaticText* m_textPlayer2Points;
+		irr::gui::IGUIStaticText* m_textProfiler;
+		int m_profilerUpdateCount;
 
 		irr::gui::IGUIButton* m_buttonAttackersTurn;
 		irr::gui::IGUIButton* m_buttonBuyPencil;
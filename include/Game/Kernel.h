@@ -3,10 +3,12 @@
 
 #include "../Camera/Capture.h"
 #include "../Camera/Calibration.h"
+#include "../Camera/PencilTracker.h"
 #include "InputHandler.h"
 #include "GameManager.h"
 
 #include <irrlicht.h>
+#include <string>
 
 namespace Game
 {
@@ -45,10 +47,33 @@ namespace Game
 		 */
 		void SetMultiThreaded(bool p_multiThreaded);
 
+		/**
+		 * @brief	Sets whether only the detected points are undistorted instead of every frame
+		 * @param	p_undistortPoints Value
+		 */
+		void SetUndistortPoints(bool p_undistortPoints);
+
+		/**
+		 * @brief	Sets where the camera frames come from
+		 * @param	p_frameSource The description of the frame source
+		 * @see		Camera::FrameSource::Create
+		 */
+		void SetFrameSource(std::string p_frameSource);
+
+		/**
+		 * @brief	Sets the name of the shared memory the camera frames are published in for other processes
+		 * @param	p_sharedOutput The name, empty to not publish
+		 * @see		Camera::SharedFrameRing
+		 */
+		void SetSharedOutput(std::string p_sharedOutput);
+
 	private:
 		irr::core::dimension2du m_resolution;
 		irr::IrrlichtDevice* m_device;
 		bool m_multiThreaded;
+		bool m_undistortPoints;
+		std::string m_frameSource;
+		std::string m_sharedOutput;
 
 		InputHandler* m_inputHandler;
 		GameManager* m_gameManager;
@@ -0,0 +1,86 @@
+#ifndef __UTILITY_LATENCYHISTOGRAM_H__
+#define __UTILITY_LATENCYHISTOGRAM_H__
+
+#include <atomic>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace Utility
+{
+	/**
+	 * @brief	Lock-free latency histogram with logarithmic buckets, in the style of HdrHistogram.
+	 *			Every power of two is split into 16 buckets, so any value is stored with an error
+	 *			of at most 6.25%, from one microsecond up to more than an hour.
+	 *			Any number of threads may record and read at the same time.
+	 *
+	 * @author	Michel van Os.
+	 */
+	class LatencyHistogram
+	{
+	public:
+		/**
+		 * @brief	Creates an empty histogram.
+		 */
+		LatencyHistogram();
+
+		/**
+		 * @brief	Records a single latency.
+		 *
+		 * @param	p_microseconds The latency in microseconds.
+		 */
+		void Record(long long p_microseconds);
+
+		/**
+		 * @brief	Removes all recorded latencies.
+		 *
+		 *			Latencies recorded while resetting may be lost.
+		 */
+		void Reset();
+
+		/**
+		 * @brief	Returns the number of recorded latencies.
+		 */
+		unsigned long long GetCount();
+
+		/**
+		 * @brief	Returns the average latency in microseconds.
+		 */
+		double GetMean();
+
+		/**
+		 * @brief	Returns the highest recorded latency in microseconds.
+		 */
+		long long GetMax();
+
+		/**
+		 * @brief	Returns the latency below which the given part of the recorded latencies lie.
+		 *
+		 * @param	p_percentile The percentile, from 0 to 100.
+		 * @return	The highest latency in the bucket of the percentile, in microseconds.
+		 */
+		long long GetPercentile(double p_percentile);
+
+	private:
+		static const int C_SUB_BUCKET_BITS = 4;
+		static const int C_SUB_BUCKET_COUNT = (1 << C_SUB_BUCKET_BITS);
+		static const int C_BUCKET_COUNT = ((32 - C_SUB_BUCKET_BITS + 1) * C_SUB_BUCKET_COUNT);
+
+		std::atomic<unsigned long long> m_buckets[C_BUCKET_COUNT];
+		std::atomic<unsigned long long> m_count;
+		std::atomic<long long> m_sum;
+		std::atomic<long long> m_max;
+
+		/**
+		 * @brief	Returns the bucket a latency is counted in.
+		 */
+		static int GetBucket(unsigned int p_microseconds);
+
+		/**
+		 * @brief	Returns the highest latency that is counted in a bucket.
+		 */
+		static long long GetBucketMax(int p_bucket);
+	};
+}
+
+#endif
@@ -2,13 +2,18 @@
 #define __UTILITY_LOGGER_H__
 
 #include <ctime>
-#include <Windows.h>
-#include <typeinfo.h>
 #include <string>
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#ifdef _WIN32
+#include <Windows.h>
+#include <typeinfo.h>
 #include <direct.h>
+#else
+#include <typeinfo>
+#include <sys/stat.h>
+#endif
 
 namespace Utility
 {
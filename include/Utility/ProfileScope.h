@@ -0,0 +1,48 @@
+#ifndef __UTILITY_PROFILESCOPE_H__
+#define __UTILITY_PROFILESCOPE_H__
+
+#include "Profiler.h"
+
+namespace Utility
+{
+	/**
+	 * @brief	Times the block it lives in and records the latency in a histogram when it goes out of scope.
+	 *			Nothing is measured when the Profiler is disabled at the moment the scope starts.
+	 *
+	 *			Usage:
+	 *			{
+	 *				Utility::ProfileScope scope(m_detectHistogram);
+	 *				...
+	 *			}
+	 * @author	Michel van Os.
+	 */
+	class ProfileScope
+	{
+	public:
+		/**
+		 * @brief	Starts timing.
+		 *
+		 * @param	p_histogram The histogram to record in, from Profiler::GetHistogram.
+		 */
+		ProfileScope(LatencyHistogram* const p_histogram);
+
+		/**
+		 * @brief	Stops timing and records the latency.
+		 */
+		~ProfileScope();
+
+		/**
+		 * @brief	Stops timing without recording anything, for example when there was no work to do.
+		 */
+		void Discard();
+
+	private:
+		LatencyHistogram* m_histogram;
+		long long m_start;
+
+		ProfileScope(const ProfileScope&);
+		ProfileScope& operator=(const ProfileScope&);
+	};
+}
+
+#endif
@@ -0,0 +1,115 @@
+#ifndef __UTILITY_PROFILER_H__
+#define __UTILITY_PROFILER_H__
+
+#include "LatencyHistogram.h"
+#include "Logger.h"
+#include <atomic>
+#include <mutex>
+#include <map>
+#include <string>
+#include <sstream>
+#include <iomanip>
+
+namespace Utility
+{
+	/**
+	 * @brief	Keeps a LatencyHistogram for every named stage that is timed with a ProfileScope.
+	 *			Profiling is disabled by default; a disabled ProfileScope costs a single check.
+	 *			When a dump interval is set, Update logs a summary of all histograms through the Logger.
+	 *
+	 * @see		ProfileScope
+	 * @author	Michel van Os.
+	 */
+	class Profiler
+	{
+	public:
+		/**
+		 * @brief	Creates the Profiler.
+		 */
+		Profiler();
+
+		/**
+		 * @brief	Destroys the Profiler and all of its histograms.
+		 */
+		~Profiler();
+
+		/**
+		 * @brief	Returns a Singleton-instance of the Profiler.
+		 */
+		static Profiler* GetInstance();
+
+		/**
+		 * @brief	Resets the Singleton-instance of the Profiler and the Profiler will be destroyed.
+		 */
+		static void ResetInstance();
+
+		/**
+		 * @brief	Returns the histogram of a stage, it is created the first time it is asked for.
+		 *
+		 *			The histogram lives as long as the Profiler, so ask for it once and keep the pointer.
+		 * @param	p_name The name of the stage.
+		 */
+		LatencyHistogram* GetHistogram(const std::string& p_name);
+
+		/**
+		 * @brief	Sets whether ProfileScopes record anything.
+		 *
+		 * @param	p_state The new profiling state.
+		 */
+		void SetEnabled(const bool p_state);
+
+		/**
+		 * @brief	Returns whether ProfileScopes record anything.
+		 */
+		bool IsEnabled();
+
+		/**
+		 * @brief	Sets how often Update logs a summary.
+		 *
+		 * @param	p_seconds The number of seconds between two summaries, 0 to never log one.
+		 */
+		void SetDumpInterval(const double p_seconds);
+
+		/**
+		 * @brief	Logs a summary when the dump interval has passed. Call this once every frame.
+		 */
+		void Update();
+
+		/**
+		 * @brief	Returns a table with the count, mean, percentiles and maximum of every stage in milliseconds.
+		 */
+		std::string GetSummary();
+
+		/**
+		 * @brief	Logs the summary of every stage.
+		 */
+		void LogSummary();
+
+		/**
+		 * @brief	Clears the histograms of every stage.
+		 */
+		void ResetHistograms();
+
+		/**
+		 * @brief	Returns the current time in ticks of the high resolution clock, the same ticks as cv::getTickCount.
+		 */
+		static long long GetTicks();
+
+		/**
+		 * @brief	Converts a number of ticks to microseconds.
+		 *
+		 * @param	p_ticks The number of ticks.
+		 */
+		static long long TicksToMicroseconds(const long long p_ticks);
+
+	private:
+		static Profiler* m_profiler;
+		std::atomic<bool> m_enabled;
+		std::mutex m_mutex;
+		std::map<std::string, LatencyHistogram*> m_histograms;
+		long long m_dumpIntervalTicks;
+		long long m_lastDumpTicks;
+	};
+}
+
+#endif
@@ -45,6 +45,9 @@ namespace Camera
 		m_perViewReprojectionErrors.release();
 		m_extrinsicParameters.release();
 		m_imagePoints.release();
+		m_undistortMap1.release();
+		m_undistortMap2.release();
+		m_undistortSize = cv::Size();
 	}
 
 	void CalibrationParams::Save()
@@ -168,9 +171,26 @@ namespace Camera
 		return m_cameraMatrix;
 	}
 
+	cv::Mat CalibrationParams::GetCameraMatrix(cv::Size p_size)
+	{
+		cv::Mat cameraMatrix = m_cameraMatrix.clone();
+		if (!cameraMatrix.empty() && m_imageWidth > 0 && m_imageHeight > 0)
+		{
+			double scaleX = (static_cast<double>(p_size.width) / m_imageWidth);
+			double scaleY = (static_cast<double>(p_size.height) / m_imageHeight);
+			cameraMatrix.at<double>(0, 0) *= scaleX;
+			cameraMatrix.at<double>(0, 2) *= scaleX;
+			cameraMatrix.at<double>(1, 1) *= scaleY;
+			cameraMatrix.at<double>(1, 2) *= scaleY;
+		}
+		return cameraMatrix;
+	}
+
 	void CalibrationParams::SetCameraMatrix(cv::Mat p_cameraMatrix)
 	{
 		m_cameraMatrix = p_cameraMatrix;
+		// The remap tables have to be rebuilt
+		m_undistortSize = cv::Size();
 	}
 
 	cv::Mat CalibrationParams::GetDistortionCoefficients()
@@ -181,6 +201,8 @@ namespace Camera
 	void CalibrationParams::SetDistortionCoefficients(cv::Mat p_distortionCoefficients)
 	{
 		m_distortionCoefficients = p_distortionCoefficients;
+		// The remap tables have to be rebuilt
+		m_undistortSize = cv::Size();
 	}
 
 	double CalibrationParams::GetAverageReprojectionError()
@@ -222,4 +244,39 @@ namespace Camera
 	{
 		m_imagePoints = p_imagePoints;
 	}
+
+	void CalibrationParams::Undistort(const cv::Mat& p_source, cv::Mat& p_destination)
+	{
+		if (p_source.size() != m_undistortSize)
+		{
+			UpdateUndistortMaps(p_source.size());
+		}
+
+		cv::remap(p_source, p_destination, m_undistortMap1, m_undistortMap2,
+				cv::INTER_LINEAR, cv::BORDER_CONSTANT);
+	}
+
+	void CalibrationParams::UpdateUndistortMaps(cv::Size p_size)
+	{
+		// CV_16SC2 gives the fixed-point tables remap can use without converting them each call.
+		// The camera matrix is also used as new camera matrix, just like cv::undistort does.
+		// The camera may have been switched to another size than the calibrated one
+		cv::Mat cameraMatrix = GetCameraMatrix(p_size);
+		cv::initUndistortRectifyMap(cameraMatrix, m_distortionCoefficients, cv::Mat(),
+				cameraMatrix, p_size, CV_16SC2, m_undistortMap1, m_undistortMap2);
+		m_undistortSize = p_size;
+	}
+
+	void CalibrationParams::UndistortPoints(std::vector<cv::Point2f>& p_points, cv::Size p_size)
+	{
+		if (m_isOpenedAndGood && !p_points.empty())
+		{
+			std::vector<cv::Point2f> undistorted;
+			cv::Mat cameraMatrix = GetCameraMatrix(p_size);
+			// Passing the camera matrix as P keeps the points in pixel coordinates
+			cv::undistortPoints(p_points, undistorted, cameraMatrix,
+					m_distortionCoefficients, cv::noArray(), cameraMatrix);
+			p_points = undistorted;
+		}
+	}
 }
\ No newline at end of file
@@ -0,0 +1,74 @@
+#include "Camera/CameraSource.h"
+
+namespace Camera
+{
+	CameraSource::CameraSource(int p_cameraId)
+	{
+		m_capture = cv::VideoCapture(p_cameraId);
+		m_startTicks = cv::getTickCount();
+		m_readTicks = 0;
+		m_timestamp = 0.0;
+
+		double fps = m_capture.get(CV_CAP_PROP_FPS);
+		if (fps <= 0.0)
+		{
+			// Most drivers do not report it, assume a regular webcam
+			fps = 30.0;
+		}
+		// A frame counts as ready a little early, the read then waits for at most the remainder
+		m_intervalTicks = static_cast<int64>((cv::getTickFrequency() * 0.9) / fps);
+	}
+
+	CameraSource::~CameraSource()
+	{
+		Release();
+	}
+
+	bool CameraSource::IsOpened()
+	{
+		return m_capture.isOpened();
+	}
+
+	cv::Size CameraSource::GetSize()
+	{
+		return cv::Size(
+				static_cast<int>(m_capture.get(CV_CAP_PROP_FRAME_WIDTH)),
+				static_cast<int>(m_capture.get(CV_CAP_PROP_FRAME_HEIGHT)));
+	}
+
+	bool CameraSource::IsFrameReady()
+	{
+		return (m_capture.isOpened() && (cv::getTickCount() - m_readTicks) >= m_intervalTicks);
+	}
+
+	bool CameraSource::SetSize(cv::Size p_size)
+	{
+		if (!m_capture.isOpened())
+		{
+			return false;
+		}
+
+		m_capture.set(CV_CAP_PROP_FRAME_WIDTH, p_size.width);
+		m_capture.set(CV_CAP_PROP_FRAME_HEIGHT, p_size.height);
+		// Drivers silently pick the closest mode they have
+		return (GetSize() == p_size);
+	}
+
+	bool CameraSource::Read(cv::Mat& p_image)
+	{
+		m_capture >> p_image;
+		m_readTicks = cv::getTickCount();
+		m_timestamp = (((cv::getTickCount() - m_startTicks) * 1000.0) / cv::getTickFrequency());
+		return !p_image.empty();
+	}
+
+	double CameraSource::GetTimestamp()
+	{
+		return m_timestamp;
+	}
+
+	void CameraSource::Release()
+	{
+		m_capture.release();
+	}
+}
@@ -0,0 +1,126 @@
+#include "Camera/CameraTexture.h"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace Camera
+{
+	CameraTexture::CameraTexture(irr::video::ITexture* p_front, irr::video::ITexture* p_back)
+	{
+		m_textures[0] = p_front;
+		m_textures[1] = ((p_back != NULL) ? p_back : p_front);
+		m_front = 0;
+		m_ssse3 = HasSsse3();
+		m_formatReported = false;
+	}
+
+	CameraTexture::~CameraTexture()
+	{
+	}
+
+	bool CameraTexture::Upload(const cv::Mat& p_image)
+	{
+		int back = (1 - m_front);
+		irr::video::ITexture* texture = m_textures[back];
+		// Headless runs have nothing to show the frame on
+		if (texture == NULL || p_image.empty() || p_image.type() != CV_8UC3)
+		{
+			return false;
+		}
+
+		if (texture->getColorFormat() != irr::video::ECF_A8R8G8B8)
+		{
+			if (!m_formatReported)
+			{
+				m_formatReported = true;
+				Utility::Logger::GetInstance()->Log(Utility::Logger::LOG_ERROR, "CameraTexture: The texture is not A8R8G8B8, frames are not shown");
+			}
+			return false;
+		}
+
+		// Nothing in the texture is read, so the driver does not have to copy it back first
+		unsigned char* buffer = static_cast<unsigned char*>(texture->lock(irr::video::ETLM_WRITE_ONLY));
+		if (buffer == NULL)
+		{
+			return false;
+		}
+
+		// The driver may have padded the rows or rounded the texture up to a power of two
+		irr::core::dimension2du size = texture->getSize();
+		int rows = std::min(p_image.rows, static_cast<int>(size.Height));
+		int columns = std::min(p_image.cols, static_cast<int>(size.Width));
+		irr::u32 pitch = texture->getPitch();
+		for (int row = 0; row < rows; ++row)
+		{
+			ConvertRow(p_image.ptr<unsigned char>(row), (buffer + (row * pitch)), columns, m_ssse3);
+		}
+		texture->unlock();
+
+		m_front = back;
+		return true;
+	}
+
+	irr::video::ITexture* CameraTexture::GetTexture()
+	{
+		return m_textures[m_front];
+	}
+
+	void CameraTexture::ConvertRow(const unsigned char* p_source, unsigned char* p_destination, int p_pixels, bool p_ssse3)
+	{
+		int pixel = 0;
+
+#ifdef CAMERA_TEXTURE_SSSE3
+		if (p_ssse3)
+		{
+			// Spreads 4 BGR pixels over 16 bytes, the alpha bytes are zeroed and filled in afterwards
+			const __m128i spread = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+			const __m128i alpha = _mm_set1_epi32(static_cast<int>(0xFF000000));
+
+			// 16 pixels are 48 bytes in and 64 bytes out
+			for (; (pixel + 16) <= p_pixels; pixel += 16)
+			{
+				const unsigned char* source = (p_source + (pixel * 3));
+				unsigned char* destination = (p_destination + (pixel * 4));
+				__m128i first = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source));
+				__m128i second = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + 16));
+				__m128i third = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + 32));
+
+				// Line up bytes 0, 12, 24 and 36 at the start of a register
+				__m128i pixels0 = first;
+				__m128i pixels1 = _mm_alignr_epi8(second, first, 12);
+				__m128i pixels2 = _mm_alignr_epi8(third, second, 8);
+				__m128i pixels3 = _mm_srli_si128(third, 4);
+
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(destination), _mm_or_si128(_mm_shuffle_epi8(pixels0, spread), alpha));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(destination + 16), _mm_or_si128(_mm_shuffle_epi8(pixels1, spread), alpha));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(destination + 32), _mm_or_si128(_mm_shuffle_epi8(pixels2, spread), alpha));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(destination + 48), _mm_or_si128(_mm_shuffle_epi8(pixels3, spread), alpha));
+			}
+		}
+#endif
+
+		for (; pixel < p_pixels; ++pixel)
+		{
+			p_destination[(pixel * 4)] = p_source[(pixel * 3)];
+			p_destination[(pixel * 4) + 1] = p_source[(pixel * 3) + 1];
+			p_destination[(pixel * 4) + 2] = p_source[(pixel * 3) + 2];
+			p_destination[(pixel * 4) + 3] = 255;
+		}
+	}
+
+	bool CameraTexture::HasSsse3()
+	{
+#if defined(_MSC_VER)
+		int info[4];
+		__cpuid(info, 1);
+		// SSSE3 is bit 9 of ecx
+		return ((info[2] & (1 << 9)) != 0);
+#elif defined(CAMERA_TEXTURE_SSSE3)
+		// Compiled for a processor that has it
+		return true;
+#else
+		return false;
+#endif
+	}
+}
@@ -2,37 +2,111 @@
 
 namespace Camera
 {
-	Capture::Capture(bool p_runInOwnThread, irr::core::dimension2du p_resolution, irr::video::ITexture* p_texture)
+	Capture::Capture(bool p_runInOwnThread, irr::core::dimension2du p_resolution, irr::video::ITexture* p_texture, irr::video::ITexture* p_backTexture, FrameSource* p_frameSource)
 	{
-		m_texture = p_texture;
+		m_texture = new CameraTexture(p_texture, p_backTexture);
 		m_resolution = p_resolution;
 		m_runInOwnThread = p_runInOwnThread;
 		m_params = new CalibrationParams("resources/camera_calibration_out.xml");
-		m_capture = cv::VideoCapture(CV_CAP_ANY);
-		m_pointDetector = new PointDetector();
+		m_frameSource = p_frameSource;
+		m_pointDetector = new PointDetector(m_params);
+		m_frameBuffer = new FrameBuffer();
+		m_pipelined = true;
+		m_asyncAcquisition = true;
+		m_notReadyPolls = 0;
+		m_grabQueue = new FrameQueue();
+		m_rectifyQueue = new FrameQueue();
+		m_detectQueue = new FrameQueue();
+		const char* histogramNames[STAGE_COUNT] = { "capture.grab", "capture.rectify", "capture.detect", "capture.texture" };
+		for (int stage = 0; stage < STAGE_COUNT; ++stage)
+		{
+			m_stageThreads[stage] = NULL;
+			m_stageFrames[stage] = 0;
+			m_stageTicks[stage] = 0;
+			m_stageHistograms[stage] = Utility::Profiler::GetInstance()->GetHistogram(histogramNames[stage]);
+		}
+		m_uploadHistogram = Utility::Profiler::GetInstance()->GetHistogram("capture.upload");
+		m_startTicks = 0;
+		m_colorClassifier = new ColorClassifier();
+		m_colorModel = new ColorModel();
+		m_segmentationMode = SEGMENTATION_BACKPROJECTION;
+		m_segmentationScale = 4;
+		m_refinedCorner.resize(1);
+		m_colorModelInterval = 15;
+		m_colorModelFrames = 0;
+		m_colorModelRate = 0.05f;
+		m_cornerTracker = new CornerTracker();
+		m_motionGate = new MotionGate();
+		m_motionGating = true;
+		m_surfaceLocked = false;
+		m_analysis = 0;
+		m_pencilAnalysis = 0;
+		m_pencilsCached = false;
+		m_reusedPencilSets = 0;
+		m_workspace = new DetectionWorkspace();
+		m_poseEstimator = new PoseEstimator(m_params);
+		m_posePredictor = new PosePredictor();
+		m_posePrediction = true;
+		m_maxPrediction = 0.1;
+		m_poseStartTicks = Utility::Profiler::GetTicks();
 		m_fov = 60.0f;
 		m_running = false;
+		m_thread = NULL;
+		// Created up front, input events can arrive before the worker is started
+		m_mutex = new std::mutex();
 
 		m_chosen = false;
-		m_lost = true;
-		// Get the screen size from opencv
-		m_size = cv::Size(
-				static_cast<int>(m_capture.get(CV_CAP_PROP_FRAME_WIDTH)),
-				static_cast<int>(m_capture.get(CV_CAP_PROP_FRAME_HEIGHT)));
+		m_selectionChanged = false;
+		// Get the screen size from the frame source
+		m_size = m_frameSource->GetSize();
 		// Calculate the half of the with and height
 		m_sizeHalfed = cv::Size(
 				((m_size.width - 1) / 2),
 				((m_size.height - 1) / 2));
 		m_center = cv::Point(((m_size.width - 1) / 2), ((m_size.height - 1) / 2));
+		m_selection = m_center;
 		m_ratio = 0.0f;
 		m_lineRatio = 0.0f;
 		m_pixelDistance = 100.0f;
 		m_boundingBox = cv::Rect(0, 0, m_size.width, m_size.height);
 
+		// Every camera mode halves the one before it, down to the smallest a webcam usually has
+		std::vector<cv::Size> modes;
+		for (cv::Size mode = m_size; mode.width >= 160; mode = cv::Size((mode.width / 2), (mode.height / 2)))
+		{
+			modes.push_back(mode);
+		}
+		if (modes.empty())
+		{
+			modes.push_back(m_size);
+		}
+		m_resolutionController = new ResolutionController(modes, m_segmentationScale);
+		m_resolutionScaling = true;
+		m_referenceSize = m_size;
+		m_requestedSize = m_size;
+		m_grabSize = m_size;
+		m_modeSwitching = true;
+		m_sharedRing = NULL;
+
+		m_roiTracking = true;
+		m_roiMargin = 40;
+		m_roiMaxLostFrames = 5;
+		m_lostFrames = 0;
+		m_roiHits = 0;
+		m_roiFallbacks = 0;
+		m_cornerTracking = true;
+		m_trackedFrames = 0;
+		m_redetections = 0;
+
+		m_undistortMode = UNDISTORT_FRAME;
+		m_backgroundUndistortInterval = 0;
+		m_frameCount = 0;
+
+		m_imageCorners = Corners();
 		m_corners = Corners();
 		m_defaultRotation = 0.0f;
+		m_transformation = irr::core::IdentityMatrix;
 
-		m_image = cv::Mat(m_size.width, m_size.height, CV_8U);
 		// Setup default setings if the calibration info cannot be loaded
 		if (!m_params->GetIsOpenedAndGood())
 		{
@@ -43,7 +117,10 @@ namespace Camera
 					fx, 0.0, m_sizeHalfed.width,
 					0.0, fy, m_sizeHalfed.height,
 					0.0, 0.0, 1.0));
+			m_params->SetImageWidth(m_size.width);
+			m_params->SetImageHeight(m_size.height);
 		}
+		m_poseEstimator->SetFrameSize(m_size);
 	}
 
 	Capture::~Capture()
@@ -53,22 +130,65 @@ namespace Camera
 
 	void Capture::Cleanup()
 	{
-		if (m_pointDetector)
-		{
-			delete m_pointDetector;
-		}
-
 		m_running = false;
-		if (m_runInOwnThread)
+		if (m_runInOwnThread && m_thread != NULL)
 		{
 			m_thread->join();
 			delete m_thread;
-			delete m_mutex;
 		}
+		for (int stage = 0; stage < STAGE_COUNT; ++stage)
+		{
+			if (m_stageThreads[stage] != NULL)
+			{
+				m_stageThreads[stage]->join();
+				delete m_stageThreads[stage];
+			}
+		}
+		delete m_mutex;
+
+		std::stringstream message;
+		message << "Capture: " << m_frameBuffer->GetPublishedCount() << " frames published, "
+				<< m_frameBuffer->GetDroppedCount() << " dropped, "
+				<< m_frameBuffer->GetReusedCount() << " reused, "
+				<< m_roiHits << " region hits, "
+				<< m_roiFallbacks << " region fallbacks, "
+				<< m_trackedFrames << " tracked frames, "
+				<< m_redetections << " redetections, "
+				<< m_motionGate->GetSkippedCount() << " unchanged frames skipped, "
+				<< m_reusedPencilSets << " pencil sets reused, "
+				<< m_resolutionController->GetStepDownCount() << " resolution steps down, "
+				<< m_resolutionController->GetStepUpCount() << " up, "
+				<< m_workspace->GetReallocationCount() << " frames with detection reallocations, "
+				<< m_pointDetector->GetReallocationCount() << " point detections with reallocations, "
+				<< m_pointDetector->GetRejectedCount() << " blobs not shaped like a pencil";
+		Utility::Logger::GetInstance()->Log(Utility::Logger::LOG_MESSAGE, message.str().c_str());
+		LogPipelineStatistics();
 
 		cv::destroyAllWindows();
-		m_image.release();
-		m_capture.release();
+		m_frameSource->Release();
+		delete m_frameSource;
+		delete m_grabQueue;
+		delete m_rectifyQueue;
+		delete m_detectQueue;
+		delete m_frameBuffer;
+		delete m_pointDetector;
+		delete m_colorClassifier;
+		delete m_colorModel;
+		delete m_cornerTracker;
+		delete m_motionGate;
+		delete m_workspace;
+		delete m_poseEstimator;
+		delete m_posePredictor;
+		delete m_resolutionController;
+		delete m_texture;
+		if (m_sharedRing != NULL)
+		{
+			std::stringstream shared;
+			shared << "Capture: " << m_sharedRing->GetPublishedCount() << " frames shared, "
+					<< m_sharedRing->GetOversizedCount() << " too large to share";
+			Utility::Logger::GetInstance()->Log(Utility::Logger::LOG_MESSAGE, shared.str().c_str());
+			delete m_sharedRing;
+		}
 		delete m_params;
 	}
 
@@ -79,16 +199,71 @@ namespace Camera
 			if (!m_running)
 			{
 				m_running = true;
-				m_thread = new std::thread(&Capture::Worker, this);
-				m_mutex = new std::mutex();
+				m_startTicks = cv::getTickCount();
+				if (m_pipelined)
+				{
+					// Every stage gets its own thread, connected by the frame queues
+					for (int stage = 0; stage < STAGE_COUNT; ++stage)
+					{
+						m_stageThreads[stage] = new std::thread(&Capture::StageWorker, this, stage);
+					}
+				}
+				else
+				{
+					m_thread = new std::thread(&Capture::Worker, this);
+				}
 			}
 		}
 		else
 		{
+			if (m_startTicks == 0)
+			{
+				m_startTicks = cv::getTickCount();
+			}
+
+			if (m_asyncAcquisition && !m_frameSource->IsFrameReady())
+			{
+				// Nothing new from the camera, the last published frame and pose stay in use
+				++m_notReadyPolls;
+				return;
+			}
 			Work();
 		}
 	}
 
+	void Capture::LogPipelineStatistics()
+	{
+		const char* names[STAGE_COUNT] = { "grab", "rectify", "detect", "texture" };
+		double elapsed = static_cast<double>(cv::getTickCount() - m_startTicks);
+
+		std::stringstream message;
+		message << "Capture: pipeline " << (m_runInOwnThread && m_pipelined ? "threaded" : "sequential");
+		if (!m_runInOwnThread && m_asyncAcquisition)
+		{
+			message << ", " << m_notReadyPolls << " polls without a frame";
+		}
+		for (int stage = 0; stage < STAGE_COUNT; ++stage)
+		{
+			// Occupancy is the part of the running time the stage was working on a frame
+			double occupancy = ((elapsed > 0.0) ? ((m_stageTicks[stage] * 100.0) / elapsed) : 0.0);
+			message << ", " << names[stage] << " " << m_stageFrames[stage] << " frames "
+					<< static_cast<int>(occupancy) << "% busy";
+		}
+		Utility::Logger::GetInstance()->Log(Utility::Logger::LOG_MESSAGE, message.str().c_str());
+
+		FrameQueue* queues[3] = { m_grabQueue, m_rectifyQueue, m_detectQueue };
+		for (int queue = 0; queue < 3; ++queue)
+		{
+			std::stringstream queueMessage;
+			queueMessage << "Capture: queue " << names[queue] << " -> " << names[queue + 1]
+					<< ", depth " << queues[queue]->GetDepth()
+					<< ", average " << queues[queue]->GetAverageDepth()
+					<< ", " << queues[queue]->GetPushedCount() << " pushed"
+					<< ", " << queues[queue]->GetDroppedCount() << " dropped";
+			Utility::Logger::GetInstance()->Log(Utility::Logger::LOG_MESSAGE, queueMessage.str().c_str());
+		}
+	}
+
 	void Capture::Lock()
 	{
 		if (m_runInOwnThread)
@@ -106,132 +281,664 @@ namespace Camera
 	}
 
 	void Capture::Work()
+	{
+		// Run every stage once, one after another
+		for (int stage = 0; stage < STAGE_COUNT; ++stage)
+		{
+			RunStage(stage);
+		}
+	}
+
+	bool Capture::RunStage(int p_stage)
+	{
+		Utility::ProfileScope scope(m_stageHistograms[p_stage]);
+		int64 start = cv::getTickCount();
+		bool processed = false;
+		switch (p_stage)
+		{
+		case STAGE_GRAB:
+			processed = GrabStage();
+			break;
+		case STAGE_RECTIFY:
+			processed = RectifyStage();
+			break;
+		case STAGE_DETECT:
+			processed = DetectStage();
+			break;
+		case STAGE_TEXTURE:
+			processed = TextureStage();
+			break;
+		}
+
+		if (processed)
+		{
+			++m_stageFrames[p_stage];
+			m_stageTicks[p_stage] += (cv::getTickCount() - start);
+		}
+		else
+		{
+			// Waiting for a frame is not part of the latency of the stage
+			scope.Discard();
+		}
+
+		return processed;
+	}
+
+	bool Capture::GrabStage()
+	{
+		if (!m_frameSource->IsOpened())
+		{
+			return false;
+		}
+
+		if (m_modeSwitching)
+		{
+			Lock();
+			cv::Size requested = m_requestedSize;
+			Unlock();
+
+			if (requested != m_grabSize)
+			{
+				// Only asked once, the frames tell the detection what the source ended up with
+				m_grabSize = requested;
+				if (!m_frameSource->SetSize(requested))
+				{
+					m_modeSwitching = false;
+					std::stringstream message;
+					message << "Capture: The frame source cannot switch to " << requested.width << "x" << requested.height
+							<< ", only the detection scale will be adjusted";
+					Utility::Logger::GetInstance()->Log(Utility::Logger::LOG_WARNING, message.str().c_str());
+				}
+			}
+		}
+
+		Frame& frame = m_grabQueue->GetWriteFrame();
+		if (!m_frameSource->Read(frame.m_image))
+		{
+			return false;
+		}
+		frame.m_timestamp = m_frameSource->GetTimestamp();
+		// Frame sources keep their own clocks, the render thread needs one it can compare with
+		frame.m_acquiredTicks = Utility::Profiler::GetTicks();
+
+		m_grabQueue->Push();
+		return true;
+	}
+
+	bool Capture::RectifyStage()
+	{
+		if (!m_grabQueue->Pop())
+		{
+			return false;
+		}
+
+		Frame& input = m_grabQueue->GetReadFrame();
+		Frame& frame = m_rectifyQueue->GetWriteFrame();
+		frame.m_timestamp = input.m_timestamp;
+		frame.m_acquiredTicks = input.m_acquiredTicks;
+
+		if (m_params->GetIsOpenedAndGood() && m_undistortMode == UNDISTORT_FRAME)
+		{
+			// Remap straight from the grabbed frame into the rectified frame
+			m_params->Undistort(input.m_image, frame.m_image);
+		}
+		else
+		{
+			// In UNDISTORT_POINTS mode the image is left distorted
+			cv::swap(input.m_image, frame.m_image);
+		}
+
+		if (m_undistortMode == UNDISTORT_POINTS && m_backgroundUndistortInterval > 0)
+		{
+			// Only update the background when an undistorted one is made
+			frame.m_backgroundUpdated = ((m_frameCount % m_backgroundUndistortInterval) == 0);
+			if (frame.m_backgroundUpdated)
+			{
+				m_params->Undistort(frame.m_image, frame.m_background);
+			}
+		}
+		else
+		{
+			frame.m_background.release();
+			frame.m_backgroundUpdated = true;
+		}
+		++m_frameCount;
+
+		m_rectifyQueue->Push();
+		return true;
+	}
+
+	bool Capture::DetectStage()
+	{
+		if (!m_rectifyQueue->Pop())
+		{
+			return false;
+		}
+
+		Frame& frame = m_detectQueue->GetWriteFrame();
+		frame.MoveFrom(m_rectifyQueue->GetReadFrame());
+		cv::Mat& image = frame.m_image;
+		long long start = Utility::Profiler::GetTicks();
+		m_workspace->Begin();
+
+		if (image.size() != m_size && image.size().area() > 0)
+		{
+			// The camera switched modes, the frames that were on their way still had the old size
+			Resize(image.size());
+		}
+
+		if (UpdateSelection())
+		{
+			// A new selection has to be detected around the new center, and its color learned again
+			m_cornerTracker->Reset();
+			m_colorModel->Reset();
+			m_motionGate->Reset();
+		}
+
+		// A static scene keeps the corners and the pose of the last analyzed frame
+		bool analyze = true;
+		if (m_motionGating && m_chosen)
+		{
+			if (!m_surfaceLocked)
+			{
+				// Nothing to keep, so the next frame to compare with is this one
+				m_motionGate->Reset();
+			}
+			analyze = m_motionGate->HasChanged(image);
+		}
+
+		bool lost = false;
+		if (analyze)
+		{
+			lost = !AnalyzeSurface(image);
+			++m_analysis;
+		}
+		m_surfaceLocked = !lost;
+
+		frame.m_lost = lost;
+		frame.m_imageCorners = m_imageCorners;
+		frame.m_corners = m_corners;
+		frame.m_pixelDistance = m_pixelDistance;
+		frame.m_lineRatio = m_lineRatio;
+		frame.m_transformation = m_transformation;
+		frame.m_velocity = irr::core::vector3df(0.0f, 0.0f, 0.0f);
+		frame.m_angularVelocity = cv::Vec3d(0.0, 0.0, 0.0);
+		frame.m_analysis = m_analysis;
+
+		if (lost)
+		{
+			m_posePredictor->Reset();
+		}
+		else if (m_posePrediction)
+		{
+			if (analyze)
+			{
+				double time = (Utility::Profiler::TicksToMicroseconds(frame.m_acquiredTicks - m_poseStartTicks) / 1000000.0);
+				frame.m_transformation = m_posePredictor->Update(m_transformation, time);
+				frame.m_velocity = m_posePredictor->GetVelocity();
+				frame.m_angularVelocity = m_posePredictor->GetAngularVelocity();
+			}
+			else
+			{
+				// Nothing moved, so the pose stays where it is
+				frame.m_transformation = m_posePredictor->GetPose();
+			}
+		}
+
+		m_workspace->End();
+
+		if (m_resolutionScaling)
+		{
+			if (!m_modeSwitching && m_resolutionController->GetModeCount() > 1)
+			{
+				m_resolutionController->SetModes(std::vector<cv::Size>(1, m_referenceSize));
+			}
+
+			double milliseconds = (Utility::Profiler::TicksToMicroseconds(Utility::Profiler::GetTicks() - start) / 1000.0);
+			if (m_resolutionController->Update(milliseconds))
+			{
+				ApplyResolution();
+			}
+		}
+
+		m_detectQueue->Push();
+		return true;
+	}
+
+	bool Capture::TextureStage()
+	{
+		if (!m_detectQueue->Pop())
+		{
+			return false;
+		}
+
+		// The back frame is only touched by this thread until it is published
+		Frame& frame = m_frameBuffer->GetBackFrame();
+		frame.MoveFrom(m_detectQueue->GetReadFrame());
+		if (frame.m_backgroundUpdated)
+		{
+			// The render thread converts straight into the texture, only a size change has to happen here
+			const cv::Mat& background = (frame.m_background.empty() ? frame.m_image : frame.m_background);
+			if (background.size() != m_referenceSize && m_referenceSize.area() > 0)
+			{
+				// The texture keeps the size of the start when the camera runs in a smaller mode
+				cv::resize(background, frame.m_textureImage, m_referenceSize, 0.0, 0.0, cv::INTER_LINEAR);
+			}
+			else
+			{
+				frame.m_textureImage.release();
+			}
+		}
+
+		if (m_sharedRing != NULL)
+		{
+			// Copied once into the ring, readers look at it in place
+			m_sharedRing->Publish(frame);
+		}
+
+		// Publish the frame, the render thread picks it up with AcquireFrame
+		m_frameBuffer->Publish();
+		return true;
+	}
+
+	bool Capture::AnalyzeSurface(cv::Mat& p_image)
 	{
 		bool lost = true;
-		if (m_capture.isOpened())
+		// Whatever was shown for the previous frame is replaced
+		DebugOverlay::GetInstance()->Clear(DebugOverlay::SOURCE_SURFACE);
+
+		// Follow the corners of the last frame, only detect them again when that fails
+		Corners& corners = m_detectedCorners;
+		bool tracked = (m_cornerTracking && m_chosen && m_cornerTracker->Track(p_image, corners));
+		bool usedRegion = false;
+		if (tracked)
 		{
-			CaptureAndUndistort();
-			if (!m_image.empty())
+			++m_trackedFrames;
+			UpdateBoundingBox(corners);
+			lost = false;
+		}
+		else
+		{
+			// Only search the area around the last known position of the surface
+			cv::Rect region = GetSearchRegion(p_image.size());
+			usedRegion = (region.area() < p_image.size().area());
+			lost = !DetectCorners(p_image, region, corners);
+
+			if (!lost && m_chosen && m_cornerTracking)
 			{
-				cv::Mat surface = cv::Mat(m_image.clone());
-				cv::cvtColor(surface, surface, CV_BGR2HSV);
+				++m_redetections;
+				m_cornerTracker->Start(p_image, corners);
+			}
+		}
 
-				if (!m_chosen)
-				{
-					int index = static_cast<int>(((m_center.y * surface.channels()) * m_size.width) + (m_center.x * surface.channels()));
-					// Make sure we can't go out of bounds of the pixel data
-					if ((index + 2) <= (sizeof(unsigned char) * (surface.cols * surface.rows * surface.channels())))
-					{
-						m_color = cv::Scalar(surface.data[(index + 0)], surface.data[(index + 1)], surface.data[(index + 2)]);
-					}
+		if (!lost)
+		{
+			// -----
+			// At this point we are sure that we have a correct set of corners to work with
+			// -----
 
-					// DEBUG CIRCLE
-					cv::circle(m_image, m_center, 5, cv::Scalar(255, 255, 255));
-					// DEBUG BOUNDINGBOX
-					cv::rectangle(m_image, m_boundingBox, cv::Scalar(255, 255, 255));
+			m_imageCorners = corners;
+			m_corners.clear();
+			m_corners = corners;
+			if (m_undistortMode == UNDISTORT_POINTS)
+			{
+				// The frame is distorted, so only correct the corners
+				m_params->UndistortPoints(m_corners, m_size);
+			}
+			CalculateShortestAndLongestLine(m_corners);
+
+			irr::core::line2df top = irr::core::line2df(
+					irr::core::vector2df(m_corners.at(0).x, m_corners.at(0).y),
+					irr::core::vector2df(m_corners.at(1).x, m_corners.at(1).y));
+			irr::core::line2df left = irr::core::line2df(
+					irr::core::vector2df(m_corners.at(1).x, m_corners.at(1).y),
+					irr::core::vector2df(m_corners.at(2).x, m_corners.at(2).y));
+
+			m_lineRatio = left.getLength() / top.getLength();
+		}
+
+		if (!lost && m_chosen && m_segmentationMode == SEGMENTATION_BACKPROJECTION && m_colorModel->IsReady())
+		{
+			// Keep up with the light on the table, a little at a time
+			if (++m_colorModelFrames >= m_colorModelInterval)
+			{
+				m_colorModelFrames = 0;
+				UpdateColorModel(p_image, corners);
+			}
+		}
+
+		if (m_chosen && lost)
+		{
+			// ERROR BOUNDINGBOX
+			DebugOverlay::GetInstance()->AddRectangle(DebugOverlay::SOURCE_SURFACE, m_boundingBox, p_image.size(), cv::Scalar(0, 0, 255));
+		}
+
+		UpdateTrackingState(lost, usedRegion);
+
+		if (!lost)
+		{
+			m_transformation = CalculateTransformMatrix();
+		}
+		else
+		{
+			// The surface may have moved anywhere, do not start from the old pose
+			m_poseEstimator->Reset();
+		}
+
+		return !lost;
+	}
+
+	bool Capture::DetectCorners(cv::Mat& p_image, cv::Rect p_region, Corners& p_corners)
+	{
+		bool found = false;
+		bool backProjected = (m_chosen && m_segmentationMode == SEGMENTATION_BACKPROJECTION);
+		// The back-projection is searched at a lower resolution
+		int scale = (backProjected ? m_segmentationScale : 1);
+		cv::Mat edges;
+
+		if (backProjected)
+		{
+			// The mask is clean enough to find the contours in directly
+			edges = SegmentSurface(p_image, p_region);
+		}
+		else
+		{
+			cv::Mat mask = m_workspace->GetImage(DetectionWorkspace::BUFFER_MASK, p_region.size(), CV_8UC1);
+			if (!m_chosen)
+			{
+				cv::Mat surface = m_workspace->GetImage(DetectionWorkspace::BUFFER_CONVERTED, p_region.size(), CV_8UC3);
+				cv::cvtColor(p_image(p_region), surface, CV_BGR2HSV);
+
+				// Make sure we can't go out of bounds of the pixel data
+				cv::Point pixel = cv::Point(static_cast<int>(m_center.x), static_cast<int>(m_center.y));
+				if (p_region.contains(pixel))
+				{
+					cv::Vec3b color = surface.at<cv::Vec3b>(pixel - p_region.tl());
+					m_color = cv::Scalar(color.val[0], color.val[1], color.val[2]);
 				}
 
 				// -----
 				// Color detection
 				// -----
 
-				int offset = 30;
-				cv::Scalar lowerColor = cv::Scalar(m_color.val[0] - offset, m_color.val[1] - (offset * 3), m_color.val[2] - (offset * 3));
-				cv::Scalar upperColor = cv::Scalar(m_color.val[0] + offset, m_color.val[1] + (offset * 3), m_color.val[2] + (offset * 3));
-				cv::inRange(surface, lowerColor, upperColor, surface);
+				cv::Scalar lowerColor;
+				cv::Scalar upperColor;
+				GetColorRange(lowerColor, upperColor);
+				cv::inRange(surface, lowerColor, upperColor, mask);
 
-				cv::medianBlur(surface, surface, 9);
-				cv::Canny(surface, surface, 0, 255);
+				// DEBUG CIRCLE
+				DebugOverlay::GetInstance()->AddPoint(DebugOverlay::SOURCE_SURFACE, m_center, p_image.size(), cv::Scalar(255, 255, 255), 5.0f);
+				// DEBUG BOUNDINGBOX
+				DebugOverlay::GetInstance()->AddRectangle(DebugOverlay::SOURCE_SURFACE, m_boundingBox, p_image.size(), cv::Scalar(255, 255, 255));
+			}
+			else
+			{
+				// The color no longer changes, so the lookup table is only built once per selection
+				cv::Scalar lowerColor;
+				cv::Scalar upperColor;
+				GetColorRange(lowerColor, upperColor);
+				m_colorClassifier->SetRange(lowerColor, upperColor);
+				m_colorClassifier->Classify(p_image(p_region), mask);
+			}
 
-				// -----
-				// Find contours
-				// -----
+			cv::Mat filtered = m_workspace->GetImage(DetectionWorkspace::BUFFER_FILTERED, p_region.size(), CV_8UC1);
+			edges = m_workspace->GetImage(DetectionWorkspace::BUFFER_EDGES, p_region.size(), CV_8UC1);
+			cv::medianBlur(mask, filtered, 9);
+			cv::Canny(filtered, edges, 0, 255);
+		}
 
-				std::vector<std::vector<cv::Point>> contours;
-				cv::findContours(surface.clone(), contours, CV_RETR_LIST, CV_CHAIN_APPROX_SIMPLE);
+		if (edges.empty())
+		{
+			return false;
+		}
+
+		// -----
+		// Find contours
+		// -----
 
-				for (unsigned int i = 0; i < contours.size(); ++i)
+		// The offset puts the contours back in frame coordinates, downscaled contours are moved after scaling them up
+		int contourCount = m_workspace->FindContours(edges, ((scale == 1) ? p_region.tl() : cv::Point(0, 0)));
+		// The center of a downscaled pixel in frame coordinates
+		cv::Point2f scaleOffset = cv::Point2f(
+				(p_region.x + ((scale - 1) / 2.0f)),
+				(p_region.y + ((scale - 1) / 2.0f)));
+
+		for (int i = 0; i < contourCount; ++i)
+		{
+			cv::Mat contour = m_workspace->GetContour(i);
+			if (contour.empty())
+			{
+				continue;
+			}
+
+			Corners& approx = m_workspace->ApproximateContour(i);
+			if ((std::fabs(cv::contourArea(contour)) * (scale * scale)) < 100 || !cv::isContourConvex(approx))
+			{
+				continue;
+			}
+
+			if (scale != 1)
+			{
+				for (unsigned int j = 0; j < approx.size(); ++j)
 				{
-					cv::Mat curve = cv::Mat(contours[i]);
-					Corners approx;
-					// Convert from std::vector<cv::Point> to Corners
-					curve.convertTo(curve, cv::Mat(approx).type());
+					approx[j] = ((approx[j] * static_cast<float>(scale)) + scaleOffset);
+				}
+			}
 
-					cv::approxPolyDP(curve, approx, (cv::arcLength(curve, true) * 0.02), true);
-					if (std::fabs(cv::contourArea(contours[i])) < 100 || !cv::isContourConvex(approx))
-					{
-						continue;
-					}
+			int offset = 30;
+			cv::Rect boundingBox = cv::boundingRect(approx);
+			boundingBox.x -= offset;
+			boundingBox.y -= offset;
+			boundingBox.width += (offset * 2);
+			boundingBox.height += (offset * 2);
 
-					int offset = 30;
-					cv::Rect boundingBox = cv::boundingRect(approx);
-					boundingBox.x -= offset;
-					boundingBox.y -= offset;
-					boundingBox.width += (offset * 2);
-					boundingBox.height += (offset * 2);
+			if (approx.size() == 4 && boundingBox.contains(m_center))
+			{
+				m_boundingBox = boundingBox;
 
-					if (approx.size() == 4 && boundingBox.contains(m_center))
+				cv::Point2f center;
+				if (m_chosen)
+				{
+					center = cv::Point2f(0, 0);
+					for (unsigned int i = 0; i < approx.size(); ++i)
 					{
-						m_boundingBox = boundingBox;
-
-						cv::Point2f center;
-						if (m_chosen)
-						{
-							center = cv::Point2f(0, 0);
-							for (unsigned int i = 0; i < approx.size(); ++i)
-							{
-								center += approx[i];
-							}
-							center *= (1.0 / approx.size());
-						}
-						else
-						{
-							center = m_center;
-						}
-
-						if (SortCorners(approx, center))
-						{
-							// -----
-							// At this point we are sure that we have a correct set of corners to work with
-							// -----
-
-							Lock();
-							lost = false;
-							m_center = center;
-							m_corners.clear();
-							m_corners = approx;
-							CalculateShortestAndLongestLine(m_corners);
-	
-							irr::core::line2df top = irr::core::line2df(
-									irr::core::vector2df(m_corners.at(0).x, m_corners.at(0).y),
-									irr::core::vector2df(m_corners.at(1).x, m_corners.at(1).y));
-							irr::core::line2df left = irr::core::line2df(
-									irr::core::vector2df(m_corners.at(1).x, m_corners.at(1).y),
-									irr::core::vector2df(m_corners.at(2).x, m_corners.at(2).y));
-
-							m_lineRatio = left.getLength() / top.getLength();
-
-							Unlock();
-						}
+						center += approx[i];
 					}
-
-					// Release the curve
-					curve.release();
+					center *= (1.0 / approx.size());
+				}
+				else
+				{
+					center = m_center;
 				}
 
-				if (m_chosen && lost)
+				if (SortCorners(approx, center))
 				{
-					// ERROR BOUNDINGBOX
-					cv::rectangle(m_image, m_boundingBox, cv::Scalar(0, 0, 255));
+					found = true;
+					m_center = center;
+					p_corners = approx;
 				}
+			}
+		}
+
+		if (found && scale > 1)
+		{
+			// The corners are only as precise as the downscaled frame, refine them in the full frame
+			RefineCorners(p_image, p_corners, scale);
+		}
+
+		return found;
+	}
+
+	void Capture::RefineCorners(const cv::Mat& p_image, Corners& p_corners, int p_scale)
+	{
+		// The search window has to cover the uncertainty of a downscaled pixel and a bit of the edges around it
+		int half = std::max(3, (p_scale * 2));
+		int reach = (half + 2);
+		cv::TermCriteria criteria = cv::TermCriteria((cv::TermCriteria::EPS + cv::TermCriteria::COUNT), 20, 0.03);
+		cv::Rect bounds = cv::Rect(0, 0, p_image.cols, p_image.rows);
+
+		for (unsigned int i = 0; i < p_corners.size(); ++i)
+		{
+			cv::Point center = cv::Point(cvRound(p_corners[i].x), cvRound(p_corners[i].y));
+			cv::Rect window = (cv::Rect((center.x - reach), (center.y - reach), ((reach * 2) + 1), ((reach * 2) + 1)) & bounds);
+			if (window.width != ((reach * 2) + 1) || window.height != ((reach * 2) + 1))
+			{
+				// Too close to the border of the frame, keep the coarse corner
+				continue;
+			}
+
+			// Only the window is converted, never the whole frame
+			cv::Mat grey = m_workspace->GetImage(DetectionWorkspace::BUFFER_GREY, window.size(), CV_8UC1);
+			cv::cvtColor(p_image(window), grey, CV_BGR2GRAY);
 
-				m_lost = lost;
-				//cv::imshow("surface", surface);
-				//cv::waitKey(1);
-				surface.release();
+			m_refinedCorner[0] = (p_corners[i] - cv::Point2f(window.tl()));
+			cv::cornerSubPix(grey, m_refinedCorner, cv::Size(half, half), cv::Size(-1, -1), criteria);
 
-				// Update the irrlicht texture with the camera frame
-				CopyToTexture();
+			// A corner that wandered off locked onto something else
+			cv::Point2f refined = (m_refinedCorner[0] + cv::Point2f(window.tl()));
+			cv::Point2f difference = (refined - p_corners[i]);
+			if (((difference.x * difference.x) + (difference.y * difference.y)) <= static_cast<float>(half * half))
+			{
+				p_corners[i] = refined;
+			}
+		}
+	}
+
+	cv::Mat Capture::SegmentSurface(const cv::Mat& p_image, cv::Rect p_region)
+	{
+		cv::Size size = cv::Size(
+				std::max(1, (p_region.width / m_segmentationScale)),
+				std::max(1, (p_region.height / m_segmentationScale)));
+
+		cv::Mat scaled = m_workspace->GetImage(DetectionWorkspace::BUFFER_SCALED, size, CV_8UC3);
+		cv::resize(p_image(p_region), scaled, size, 0.0, 0.0, cv::INTER_AREA);
+		cv::Mat hsv = m_workspace->GetImage(DetectionWorkspace::BUFFER_CONVERTED, size, CV_8UC3);
+		cv::cvtColor(scaled, hsv, CV_BGR2HSV);
+
+		if (!m_colorModel->IsReady())
+		{
+			// Start from the area around the clicked point
+			cv::Point center = cv::Point(
+					static_cast<int>((m_center.x - p_region.x) / m_segmentationScale),
+					static_cast<int>((m_center.y - p_region.y) / m_segmentationScale));
+			// About 20 by 20 pixels of the full frame, whatever the scale
+			int half = std::max(2, (10 / m_segmentationScale));
+			cv::Rect window = (cv::Rect((center.x - half), (center.y - half), ((half * 2) + 1), ((half * 2) + 1)) & cv::Rect(0, 0, size.width, size.height));
+			if (window.area() == 0)
+			{
+				return cv::Mat();
+			}
+			m_colorModel->Learn(hsv(window), cv::Mat(), 1.0f);
+			m_colorModelFrames = 0;
+		}
+
+		cv::Mat mask = m_workspace->GetImage(DetectionWorkspace::BUFFER_MASK, size, CV_8UC1);
+		cv::Mat filtered = m_workspace->GetImage(DetectionWorkspace::BUFFER_FILTERED, size, CV_8UC1);
+		m_colorModel->Segment(hsv, mask);
+
+		// Remove specks and fill pinholes, this replaces the median blur and the edge detection
+		cv::morphologyEx(mask, filtered, cv::MORPH_OPEN, cv::Mat());
+		cv::morphologyEx(filtered, mask, cv::MORPH_CLOSE, cv::Mat());
+		return mask;
+	}
+
+	void Capture::UpdateColorModel(const cv::Mat& p_image, const Corners& p_corners)
+	{
+		cv::Rect box = (cv::boundingRect(p_corners) & cv::Rect(0, 0, p_image.cols, p_image.rows));
+		cv::Size size = cv::Size((box.width / m_segmentationScale), (box.height / m_segmentationScale));
+		if (size.width <= 0 || size.height <= 0)
+		{
+			return;
+		}
+
+		cv::Mat scaled = m_workspace->GetImage(DetectionWorkspace::BUFFER_SCALED, size, CV_8UC3);
+		cv::resize(p_image(box), scaled, size, 0.0, 0.0, cv::INTER_AREA);
+		cv::Mat hsv = m_workspace->GetImage(DetectionWorkspace::BUFFER_CONVERTED, size, CV_8UC3);
+		cv::cvtColor(scaled, hsv, CV_BGR2HSV);
+
+		// Only learn from the inside, the edges of the surface blend with the table
+		cv::Point2f center = cv::Point2f(0, 0);
+		for (unsigned int i = 0; i < p_corners.size(); ++i)
+		{
+			center += p_corners[i];
+		}
+		center *= (1.0 / p_corners.size());
+
+		cv::Point inner[4];
+		for (unsigned int i = 0; i < 4; ++i)
+		{
+			cv::Point2f corner = (center + ((p_corners[i] - center) * 0.75f) - cv::Point2f(box.tl()));
+			inner[i] = cv::Point(
+					static_cast<int>(corner.x / m_segmentationScale),
+					static_cast<int>(corner.y / m_segmentationScale));
+		}
+
+		cv::Mat mask = m_workspace->GetImage(DetectionWorkspace::BUFFER_MASK, size, CV_8UC1);
+		mask.setTo(cv::Scalar(0));
+		cv::fillConvexPoly(mask, inner, 4, cv::Scalar(255));
+		m_colorModel->Learn(hsv, mask, m_colorModelRate);
+	}
+
+	void Capture::UpdateBoundingBox(const Corners& p_corners)
+	{
+		int offset = 30;
+		m_boundingBox = cv::boundingRect(p_corners);
+		m_boundingBox.x -= offset;
+		m_boundingBox.y -= offset;
+		m_boundingBox.width += (offset * 2);
+		m_boundingBox.height += (offset * 2);
+
+		m_center = cv::Point2f(0, 0);
+		for (unsigned int i = 0; i < p_corners.size(); ++i)
+		{
+			m_center += p_corners[i];
+		}
+		m_center *= (1.0 / p_corners.size());
+
+		// The tracker keeps the sorted order, so the first corner is still the top left one
+		m_topLeft = p_corners[0];
+	}
+
+	cv::Rect Capture::GetSearchRegion(cv::Size p_imageSize)
+	{
+		cv::Rect frameRegion = cv::Rect(0, 0, p_imageSize.width, p_imageSize.height);
+		if (!m_roiTracking || !m_chosen || m_lostFrames >= m_roiMaxLostFrames)
+		{
+			return frameRegion;
+		}
+
+		cv::Rect region = m_boundingBox;
+		region.x -= m_roiMargin;
+		region.y -= m_roiMargin;
+		region.width += (m_roiMargin * 2);
+		region.height += (m_roiMargin * 2);
+
+		region &= frameRegion;
+		if (region.area() == 0)
+		{
+			return frameRegion;
+		}
+
+		return region;
+	}
+
+	void Capture::UpdateTrackingState(bool p_lost, bool p_usedRegion)
+	{
+		if (!p_lost)
+		{
+			if (p_usedRegion)
+			{
+				++m_roiHits;
+			}
+			m_lostFrames = 0;
+		}
+		else if (m_chosen)
+		{
+			++m_lostFrames;
+			if (m_roiTracking && m_lostFrames == m_roiMaxLostFrames)
+			{
+				// From the next frame on the whole frame is searched again
+				++m_roiFallbacks;
 			}
 		}
 	}
@@ -244,12 +951,72 @@ namespace Camera
 		}
 	}
 
+	void Capture::StageWorker(int p_stage)
+	{
+		while (m_running)
+		{
+			if (!RunStage(p_stage))
+			{
+				if (p_stage == STAGE_GRAB)
+				{
+					// The frame source is closed or ran out of frames
+					std::this_thread::sleep_for(std::chrono::milliseconds(10));
+				}
+				else
+				{
+					// Sleep until the previous stage pushes a frame
+					GetStageInput(p_stage)->Wait(10);
+				}
+			}
+		}
+	}
+
+	FrameQueue* Capture::GetStageInput(int p_stage)
+	{
+		switch (p_stage)
+		{
+		case STAGE_RECTIFY:
+			return m_grabQueue;
+		case STAGE_DETECT:
+			return m_rectifyQueue;
+		case STAGE_TEXTURE:
+			return m_detectQueue;
+		default:
+			return NULL;
+		}
+	}
+
 	int Capture::FindStartAndEndPoints(cv::Mat p_frame, irr::core::matrix4 p_cameraMatrix, irr::core::vector3df*& p_startPoints, irr::core::vector3df*& p_endPoints)
 	{
+		const Frame& frame = m_frameBuffer->GetFrontFrame();
 		int contourSize = 0;
-		if (m_chosen && m_corners.size() == 4)
+		if (m_chosen && frame.m_imageCorners.size() == 4)
 		{
-			contourSize = m_pointDetector->FindPointsInFrame(p_frame, m_corners, p_cameraMatrix, m_pixelDistance, m_sizeHalfed, p_startPoints, p_endPoints);
+			if (m_motionGating && m_pencilsCached && frame.m_analysis == m_pencilAnalysis && p_cameraMatrix == m_pencilCameraMatrix)
+			{
+				// Nothing changed since these pencils were found
+				++m_reusedPencilSets;
+				contourSize = static_cast<int>(m_pencilStarts.size());
+				if (contourSize > 0)
+				{
+					p_startPoints = new irr::core::vector3df[contourSize];
+					p_endPoints = new irr::core::vector3df[contourSize];
+					std::copy(m_pencilStarts.begin(), m_pencilStarts.end(), p_startPoints);
+					std::copy(m_pencilEnds.begin(), m_pencilEnds.end(), p_endPoints);
+				}
+				return contourSize;
+			}
+
+			// The corners have to be in the same coordinates as the frame
+			// The size of the frame itself, the camera may have switched modes since
+			cv::Size sizeHalfed = cv::Size(((p_frame.cols - 1) / 2), ((p_frame.rows - 1) / 2));
+			contourSize = m_pointDetector->FindPointsInFrame(p_frame, frame.m_imageCorners, p_cameraMatrix, frame.m_pixelDistance, sizeHalfed, p_startPoints, p_endPoints);
+
+			m_pencilStarts.assign(p_startPoints, (p_startPoints + ((contourSize > 0) ? contourSize : 0)));
+			m_pencilEnds.assign(p_endPoints, (p_endPoints + ((contourSize > 0) ? contourSize : 0)));
+			m_pencilCameraMatrix = p_cameraMatrix;
+			m_pencilAnalysis = frame.m_analysis;
+			m_pencilsCached = true;
 		}
 		return contourSize;
 	}
@@ -258,110 +1025,186 @@ namespace Camera
 	{
 		if (P_EVT.EventType == irr::EEVENT_TYPE::EET_MOUSE_INPUT_EVENT)
 		{
-			//devide by zero?
-			m_center.x = static_cast<float>((P_EVT.MouseInput.X - 1) / (m_resolution.Width / m_size.width));
-			m_center.y = static_cast<float>((P_EVT.MouseInput.Y - 1) / (m_resolution.Height / m_size.height));
+			Lock();
+			// The frame may have any size, it is stretched over the window
+			m_selection.x = ((P_EVT.MouseInput.X - 1) * m_size.width / static_cast<float>(m_resolution.Width));
+			m_selection.y = ((P_EVT.MouseInput.Y - 1) * m_size.height / static_cast<float>(m_resolution.Height));
+			m_selectionChanged = true;
 
 			if (P_EVT.MouseInput.isLeftPressed())
 			{
 				m_chosen = true;
 			}
+			Unlock();
 		}
 
 		return false;
 	}
 
-	irr::core::matrix4 Capture::GetTransformMatrix(irr::core::matrix4 p_cameraProjection)
+	void Capture::Select(cv::Point2f p_point)
 	{
-		// Create a new matrix to use for transformation
-		irr::core::matrix4 transformation = irr::core::IdentityMatrix;
+		Lock();
+		m_selection = p_point;
+		m_selectionChanged = true;
+		m_chosen = true;
+		Unlock();
+	}
 
-		// Only do calculations when we have 4 corners
-		if (m_corners.size() == 4)
+	void Capture::SetDebugOutput(bool p_debugOutput)
+	{
+		m_pointDetector->SetDebugOutput(p_debugOutput);
+	}
+
+	bool Capture::UpdateSelection()
+	{
+		bool changed = false;
+		Lock();
+		if (m_selectionChanged)
 		{
-			irr::core::matrix4 scaling = irr::core::IdentityMatrix;
-			irr::core::matrix4 rotation = irr::core::IdentityMatrix;
-			irr::core::matrix4 translation = irr::core::IdentityMatrix;
+			m_center = m_selection;
+			m_selectionChanged = false;
+			changed = true;
+		}
+		Unlock();
 
-			Lock();
-			// Invert the camera projection matrix
-			p_cameraProjection.makeInverse();
+		return changed;
+	}
 
-			// Caltulate the center x and y from the top left corner
-			float ltCenterX = (m_topLeft.x - m_sizeHalfed.width);
-			float ltCenterY = (m_topLeft.y - m_sizeHalfed.height);
+	void Capture::Resize(cv::Size p_size)
+	{
+		// Nothing was kept yet when the source did not report a size at the start
+		float scaleX = ((m_size.width > 0) ? (static_cast<float>(p_size.width) / m_size.width) : 1.0f);
+		float scaleY = ((m_size.height > 0) ? (static_cast<float>(p_size.height) / m_size.height) : 1.0f);
+
+		Lock();
+		// The mouse is mapped onto the frame with these
+		m_size = p_size;
+		m_sizeHalfed = cv::Size(((m_size.width - 1) / 2), ((m_size.height - 1) / 2));
+		m_selection = cv::Point2f((m_selection.x * scaleX), (m_selection.y * scaleY));
+		Unlock();
+
+		m_center = cv::Point2f((m_center.x * scaleX), (m_center.y * scaleY));
+		m_boundingBox = (cv::Rect(
+				static_cast<int>(m_boundingBox.x * scaleX),
+				static_cast<int>(m_boundingBox.y * scaleY),
+				static_cast<int>(m_boundingBox.width * scaleX),
+				static_cast<int>(m_boundingBox.height * scaleY)) & cv::Rect(0, 0, m_size.width, m_size.height));
+		for (size_t i = 0; i < m_imageCorners.size(); ++i)
+		{
+			m_imageCorners[i] = cv::Point2f((m_imageCorners[i].x * scaleX), (m_imageCorners[i].y * scaleY));
+		}
+		for (size_t i = 0; i < m_corners.size(); ++i)
+		{
+			m_corners[i] = cv::Point2f((m_corners[i].x * scaleX), (m_corners[i].y * scaleY));
+		}
 
-			// Calculates the ratio betwee the longest game line and longest capture line
-			m_ratio = m_shortestGameLine.getLength() / m_shortestLine.getLength();
-			// Multiplies the game line length with the ratio to get the pixel distance
-			/// @TODO: Adjust according to table
-			m_pixelDistance = 400.0f * m_ratio;
+		// The tracker and the gate compare with images of the old size
+		m_cornerTracker->Reset();
+		m_motionGate->Reset();
+		m_poseEstimator->SetFrameSize(m_size);
+	}
 
-			// -----
-			// Set the scaling
-			// -----
+	void Capture::ApplyResolution()
+	{
+		m_segmentationScale = m_resolutionController->GetScale();
+		cv::Size mode = m_resolutionController->GetMode();
+		Lock();
+		m_requestedSize = mode;
+		Unlock();
+
+		std::stringstream message;
+		message << "Capture: Detection took " << m_resolutionController->GetAverage() << " ms on average, now running at "
+				<< mode.width << "x" << mode.height << " and searching at 1/" << m_segmentationScale;
+		Utility::Logger::GetInstance()->Log(Utility::Logger::LOG_MESSAGE, message.str().c_str());
+	}
 
-			// Apply the scaling (no scaling; default to 1.0f)
-			scaling.setScale(irr::core::vector3df(1.0f));
+	bool Capture::AcquireFrame()
+	{
+		bool acquired = m_frameBuffer->Acquire();
+		const Frame& frame = m_frameBuffer->GetFrontFrame();
+		// Only a new frame with a new background has anything to upload
+		if (acquired && frame.m_backgroundUpdated)
+		{
+			Utility::ProfileScope scope(m_uploadHistogram);
+			if (!frame.m_textureImage.empty())
+			{
+				CopyToTexture(frame.m_textureImage);
+			}
+			else
+			{
+				CopyToTexture(frame.m_background.empty() ? frame.m_image : frame.m_background);
+			}
+		}
 
-			// -----
-			// Set the rotation
-			// -----
+		return acquired;
+	}
 
-			irr::core::line2df top = irr::core::line2df(
-					irr::core::vector2df(m_corners.at(0).x, m_corners.at(0).y),
-					irr::core::vector2df(m_corners.at(1).x, m_corners.at(1).y));
+	irr::core::matrix4 Capture::GetTransformMatrix()
+	{
+		return m_frameBuffer->GetFrontFrame().m_transformation;
+	}
 
-			irr::core::line2df bottom = irr::core::line2df(
-					irr::core::vector2df(m_corners.at(2).x, m_corners.at(2).y),
-					irr::core::vector2df(m_corners.at(3).x, m_corners.at(3).y));
+	irr::core::matrix4 Capture::GetPredictedTransformMatrix(long long p_displayTicks)
+	{
+		const Frame& frame = m_frameBuffer->GetFrontFrame();
+		if (!m_posePrediction || frame.m_lost)
+		{
+			return frame.m_transformation;
+		}
 
-			irr::core::line2df right = irr::core::line2df(
-					irr::core::vector2df(m_corners.at(1).x, m_corners.at(1).y),
-					irr::core::vector2df(m_corners.at(2).x, m_corners.at(2).y));
+		double ahead = (Utility::Profiler::TicksToMicroseconds(p_displayTicks - frame.m_acquiredTicks) / 1000000.0);
+		ahead = std::max(0.0, std::min(ahead, m_maxPrediction));
+		return PosePredictor::Extrapolate(frame.m_transformation, frame.m_velocity, frame.m_angularVelocity, ahead);
+	}
 
-			irr::core::line2df left = irr::core::line2df(
-					irr::core::vector2df(m_corners.at(3).x, m_corners.at(3).y),
-					irr::core::vector2df(m_corners.at(0).x, m_corners.at(0).y));
-
-			/// TODO: Adjust according to table
-			float range = 1.0f;// 0.8f;
-			// Create a 3D vector to contain the new angles
-			irr::core::vector3df angles = irr::core::vector3df(
-					 static_cast<float>(((top.getLength() / bottom.getLength()) - 1.0f) * (irr::core::HALF_PI / range)),
-					-static_cast<float>(std::atan2(top.end.Y - top.start.Y, top.end.X - top.start.X) * (180.0f / irr::core::PI)),
-					 static_cast<float>(((right.getLength() / left.getLength()) - 1.0f) * (irr::core::HALF_PI / range)));
-
-			rotation.setInverseRotationRadians(irr::core::vector3df(
-					-static_cast<float>(angles.Z > irr::core::HALF_PI ? irr::core::HALF_PI : (angles.Z < -irr::core::HALF_PI ? -irr::core::HALF_PI : angles.Z)),
-					 static_cast<float>(m_defaultRotation + (angles.Y * (irr::core::PI / 180.0f))),
-					-static_cast<float>(angles.X > irr::core::HALF_PI ? irr::core::HALF_PI : (angles.X < -irr::core::HALF_PI ? -irr::core::HALF_PI : angles.X))));
+	long long Capture::GetAcquiredTicks()
+	{
+		return m_frameBuffer->GetFrontFrame().m_acquiredTicks;
+	}
 
-			// -----
-			// Set the translation
-			// -----
+	unsigned long Capture::GetSequence()
+	{
+		return m_frameBuffer->GetFrontFrame().m_sequence;
+	}
 
-			// Create a 3D vector to contain the new position
-			irr::core::vector3df position = irr::core::vector3df(
-					static_cast<float>(ltCenterX),
-					static_cast<float>(ltCenterY),
-					static_cast<float>(0.0f));
-			// Transform using the inverted camera matrix
-			p_cameraProjection.transformVect(position);
+	irr::core::matrix4 Capture::CalculateTransformMatrix()
+	{
+		// Only do calculations when we have 4 corners
+		if (m_corners.size() != 4)
+		{
+			return m_transformation;
+		}
 
-			// Apply translation (y translation is done in the camera)
-			translation.setInverseTranslation(irr::core::vector3df(
-					 static_cast<float>(position.Y * (m_pixelDistance / m_sizeHalfed.height)),
-					-static_cast<float>(position.Z),
-					 static_cast<float>(position.X * (m_pixelDistance / m_sizeHalfed.width))));
+		// Calculates the ratio betwee the longest game line and longest capture line.
+		// The line is measured in pixels of the size at the start, so a smaller camera mode does not move the camera.
+		float referenceScale = (static_cast<float>(m_referenceSize.width) / m_size.width);
+		m_ratio = m_shortestGameLine.getLength() / (m_shortestLine.getLength() * referenceScale);
+		// Multiplies the game line length with the ratio to get the pixel distance
+		/// @TODO: Adjust according to table
+		m_pixelDistance = 400.0f * m_ratio;
+
+		// The pose of the playground as seen by the camera
+		irr::core::matrix4 pose;
+		float height = m_shortestGameLine.getLength();
+		if (!m_poseEstimator->Estimate(m_corners, height, (height * m_lineRatio), pose))
+		{
+			return m_transformation;
+		}
 
-			// Merge scaling, rotation and translation into the transformation
-			transformation = scaling * (translation * rotation);
+		// Rotate the playground around its own up axis before placing it
+		irr::core::matrix4 rotation = irr::core::IdentityMatrix;
+		rotation.setRotationRadians(irr::core::vector3df(0.0f, m_defaultRotation, 0.0f));
 
-			Unlock();
-		}
+		// Move from view space into the world through the game camera (see GameManager::SetupCamera)
+		irr::core::matrix4 view;
+		view.buildCameraLookAtMatrixLH(
+				irr::core::vector3df(0.0f, m_pixelDistance, 0.0f),
+				irr::core::vector3df(0.0f, 0.0f, 1.0f),
+				irr::core::vector3df(0.0f, 1.0f, 0.0f));
+		irr::core::matrix4 inverseView;
+		view.getInverse(inverseView);
 
-		return transformation;
+		return inverseView * (pose * rotation);
 	}
 
 	bool Capture::HasChosen()
@@ -371,7 +1214,7 @@ namespace Camera
 
 	bool Capture::IsLost()
 	{
-		return m_lost;
+		return m_frameBuffer->GetFrontFrame().m_lost;
 	}
 
 	float Capture::GetFov()
@@ -386,7 +1229,7 @@ namespace Camera
 
 	float Capture::GetPixelDistance()
 	{
-		return m_pixelDistance;
+		return m_frameBuffer->GetFrontFrame().m_pixelDistance;
 	}
 
 	irr::core::line2df Capture::GetShortestGameLine()
@@ -403,28 +1246,21 @@ namespace Camera
 	{
 		irr::core::line2df line = irr::core::line2df(
 				irr::core::vector2df(0.0f, 0.0f),
-				irr::core::vector2df(0.0f, (m_shortestGameLine.getLength() * m_lineRatio)));
+				irr::core::vector2df(0.0f, (m_shortestGameLine.getLength() * m_frameBuffer->GetFrontFrame().m_lineRatio)));
 
 		return line;
 	}
 
-	void Capture::CaptureAndUndistort()
+	void Capture::GetColorRange(cv::Scalar& p_lower, cv::Scalar& p_upper)
 	{
-		m_capture >> m_image;
-		if (m_params->GetIsOpenedAndGood() && !m_image.empty())
-		{
-			cv::undistort(m_image.clone(), m_image,
-					m_params->GetCameraMatrix(),
-					m_params->GetDistortionCoefficients());
-		}
+		int offset = 30;
+		p_lower = cv::Scalar(m_color.val[0] - offset, m_color.val[1] - (offset * 3), m_color.val[2] - (offset * 3));
+		p_upper = cv::Scalar(m_color.val[0] + offset, m_color.val[1] + (offset * 3), m_color.val[2] + (offset * 3));
 	}
 
-	void Capture::CopyToTexture()
+	void Capture::CopyToTexture(const cv::Mat& p_image)
 	{
-		cv::cvtColor(m_image, m_image, CV_BGR2BGRA, 4);
-		unsigned char* buffer = static_cast<unsigned char*>(m_texture->lock());
-		memcpy(buffer, m_image.data, (sizeof(unsigned char) * ((m_image.rows * m_image.cols) * m_image.channels())));
-		m_texture->unlock();
+		m_texture->Upload(p_image);
 	}
 
 	cv::Point2f Capture::ComputeCross(cv::Vec4i p_vec1, cv::Vec4i p_vec2)
@@ -456,30 +1292,38 @@ namespace Camera
 
 	bool Capture::SortCorners(Corners& p_corners, cv::Point2f p_center)
 	{
-		Corners top;
-		Corners bot;
+		if (p_corners.size() != 4)
+		{
+			return false;
+		}
+
+		// Fixed arrays, this runs for every candidate contour
+		cv::Point2f top[4];
+		cv::Point2f bot[4];
+		int topCount = 0;
+		int botCount = 0;
 		for (unsigned int i = 0; i < p_corners.size(); i++)
 		{
 			if (p_corners[i].y < p_center.y)
 			{
-				top.push_back(p_corners[i]);
+				top[topCount++] = p_corners[i];
 			}
 			else
 			{
-				bot.push_back(p_corners[i]);
+				bot[botCount++] = p_corners[i];
 			}
 		}
 
-		if (top.size() != bot.size())
+		if (topCount != botCount)
 		{
 			return false;
 		}
 
-		Corners corners;
-		corners.push_back(top[0].x > top[1].x ? top[1] : top[0]);
-		corners.push_back(top[0].x > top[1].x ? top[0] : top[1]);
-		corners.push_back(bot[0].x < bot[1].x ? bot[1] : bot[0]);
-		corners.push_back(bot[0].x < bot[1].x ? bot[0] : bot[1]);
+		cv::Point2f corners[4];
+		corners[0] = (top[0].x > top[1].x ? top[1] : top[0]);
+		corners[1] = (top[0].x > top[1].x ? top[0] : top[1]);
+		corners[2] = (bot[0].x < bot[1].x ? bot[1] : bot[0]);
+		corners[3] = (bot[0].x < bot[1].x ? bot[0] : bot[1]);
 
 		if (m_topLeft.x > 0 && m_topLeft.y > 0 && m_chosen)
 		{
@@ -490,12 +1334,10 @@ namespace Camera
 					offset * 2,
 					offset * 2);
 
-			for (unsigned int i = 0; i < corners.size(); ++i)
+			for (unsigned int i = 0; i < 4; ++i)
 			{
-				corners.push_back(corners.front());
-				corners.erase(corners.begin());
-
-				if (tlbb.contains(corners.at(0)))
+				std::rotate(corners, (corners + 1), (corners + 4));
+				if (tlbb.contains(corners[0]))
 				{
 					break;
 				}
@@ -503,17 +1345,16 @@ namespace Camera
 		}
 
 		// Update m_topLeft
-		m_topLeft = corners.at(0);
+		m_topLeft = corners[0];
 
-		p_corners.clear();
-		p_corners.push_back(corners.at(0));
-		p_corners.push_back(corners.at(1));
-		p_corners.push_back(corners.at(2));
-		p_corners.push_back(corners.at(3));
+		for (unsigned int i = 0; i < 4; ++i)
+		{
+			p_corners[i] = corners[i];
+		}
 		return true;
 	}
 
-	void Capture::CalculateShortestAndLongestLine(Corners p_corners)
+	void Capture::CalculateShortestAndLongestLine(const Corners& p_corners)
 	{
 		irr::core::line2df shortestLine;
 		irr::core::line2df longestLine;
@@ -554,11 +1395,150 @@ namespace Camera
 
 	cv::Mat Capture::GetImage()
 	{
-		return m_image;
+		return m_frameBuffer->GetFrontFrame().m_image;
+	}
+
+	irr::video::ITexture* Capture::GetTexture()
+	{
+		return m_texture->GetTexture();
 	}
 
 	irr::core::dimension2du Capture::GetCaptureSize()
 	{
-		return irr::core::dimension2du(m_size.width, m_size.height);
+		return irr::core::dimension2du(m_referenceSize.width, m_referenceSize.height);
+	}
+
+	void Capture::SetUndistortMode(UndistortMode p_undistortMode)
+	{
+		m_undistortMode = p_undistortMode;
+		m_pointDetector->SetUndistortPoints(m_undistortMode == UNDISTORT_POINTS);
+	}
+
+	void Capture::SetBackgroundUndistortInterval(int p_interval)
+	{
+		m_backgroundUndistortInterval = p_interval;
+	}
+
+	void Capture::SetRoiTracking(bool p_roiTracking)
+	{
+		m_roiTracking = p_roiTracking;
+	}
+
+	void Capture::SetRoiMargin(int p_margin)
+	{
+		m_roiMargin = p_margin;
+	}
+
+	void Capture::SetRoiMaxLostFrames(int p_maxLostFrames)
+	{
+		m_roiMaxLostFrames = p_maxLostFrames;
+	}
+
+	unsigned long Capture::GetRoiHitCount()
+	{
+		return m_roiHits;
+	}
+
+	unsigned long Capture::GetRoiFallbackCount()
+	{
+		return m_roiFallbacks;
+	}
+
+	void Capture::SetCornerTracking(bool p_cornerTracking)
+	{
+		m_cornerTracking = p_cornerTracking;
+	}
+
+	void Capture::SetCornerTrackingMaxError(float p_maxError)
+	{
+		m_cornerTracker->SetMaxError(p_maxError);
+	}
+
+	unsigned long Capture::GetTrackedFrameCount()
+	{
+		return m_trackedFrames;
+	}
+
+	unsigned long Capture::GetRedetectionCount()
+	{
+		return m_redetections;
+	}
+
+	void Capture::SetPipelined(bool p_pipelined)
+	{
+		m_pipelined = p_pipelined;
+	}
+
+	void Capture::SetAsyncAcquisition(bool p_asyncAcquisition)
+	{
+		m_asyncAcquisition = p_asyncAcquisition;
+	}
+
+	void Capture::SetSegmentationMode(SegmentationMode p_segmentationMode)
+	{
+		m_segmentationMode = p_segmentationMode;
+	}
+
+	void Capture::SetSegmentationScale(int p_scale)
+	{
+		m_segmentationScale = std::max(1, p_scale);
+		m_resolutionController->SetMinScale(m_segmentationScale);
+	}
+
+	bool Capture::SetSharedOutput(std::string p_name, int p_slotCount)
+	{
+		delete m_sharedRing;
+		m_sharedRing = new SharedFrameRing();
+		// Smaller camera modes fit in the room of the size at the start
+		size_t capacity = (static_cast<size_t>(m_referenceSize.area()) * 3);
+		if (!m_sharedRing->Create(p_name, p_slotCount, capacity))
+		{
+			delete m_sharedRing;
+			m_sharedRing = NULL;
+			return false;
+		}
+
+		std::string message = "Capture: Sharing frames as " + p_name;
+		Utility::Logger::GetInstance()->Log(Utility::Logger::LOG_MESSAGE, message.c_str());
+		return true;
+	}
+
+	void Capture::SetProcessingBudget(double p_milliseconds)
+	{
+		m_resolutionScaling = (p_milliseconds > 0.0);
+		if (m_resolutionScaling)
+		{
+			m_resolutionController->SetBudget(p_milliseconds);
+		}
+	}
+
+	void Capture::SetMotionGating(bool p_motionGating)
+	{
+		m_motionGating = p_motionGating;
+	}
+
+	void Capture::SetPosePrediction(bool p_posePrediction)
+	{
+		m_posePrediction = p_posePrediction;
+	}
+
+	void Capture::SetQueueDepth(int p_depth)
+	{
+		delete m_grabQueue;
+		delete m_rectifyQueue;
+		delete m_detectQueue;
+		m_grabQueue = new FrameQueue(p_depth);
+		m_rectifyQueue = new FrameQueue(p_depth);
+		m_detectQueue = new FrameQueue(p_depth);
+	}
+
+	unsigned long Capture::GetDroppedFrameCount()
+	{
+		return m_frameBuffer->GetDroppedCount();
+	}
+
+	unsigned long Capture::GetReusedFrameCount()
+	{
+		return m_frameBuffer->GetReusedCount();
 	}
 }
\ No newline at end of file
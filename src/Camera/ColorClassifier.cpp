@@ -0,0 +1,239 @@
+#include "Camera/ColorClassifier.h"
+
+#include <cstring>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#include <immintrin.h>
+#define KB06_AVX2_TARGET
+#elif defined(__GNUC__)
+#include <cpuid.h>
+#include <immintrin.h>
+#define KB06_AVX2_TARGET __attribute__((target("avx2")))
+#endif
+
+namespace Camera
+{
+	/**
+	 * @brief	Builds the lookup table for a range of blue values
+	 */
+	class ColorTableBody : public cv::ParallelLoopBody
+	{
+	public:
+		ColorTableBody(ColorClassifier* p_classifier)
+		{
+			m_classifier = p_classifier;
+		}
+
+		void operator()(const cv::Range& p_range) const
+		{
+			// Every row holds one green value and every column one red value
+			cv::Mat colors = cv::Mat(256, 256, CV_8UC3);
+			cv::Mat hsv;
+			cv::Mat mask;
+
+			for (int b = p_range.start; b < p_range.end; ++b)
+			{
+				for (int g = 0; g < 256; ++g)
+				{
+					unsigned char* row = colors.ptr<unsigned char>(g);
+					for (int r = 0; r < 256; ++r)
+					{
+						row[(r * 3) + 0] = static_cast<unsigned char>(b);
+						row[(r * 3) + 1] = static_cast<unsigned char>(g);
+						row[(r * 3) + 2] = static_cast<unsigned char>(r);
+					}
+				}
+
+				// Exactly the calls the classifier replaces
+				cv::cvtColor(colors, hsv, CV_BGR2HSV);
+				cv::inRange(hsv, m_classifier->m_lower, m_classifier->m_upper, mask);
+
+				for (int g = 0; g < 256; ++g)
+				{
+					const unsigned char* row = mask.ptr<unsigned char>(g);
+					unsigned int* words = &m_classifier->m_table[((b << 16) | (g << 8)) >> 5];
+					for (int word = 0; word < 8; ++word)
+					{
+						unsigned int bits = 0;
+						for (int bit = 0; bit < 32; ++bit)
+						{
+							if (row[(word * 32) + bit] != 0)
+							{
+								bits |= (1u << bit);
+							}
+						}
+						words[word] = bits;
+					}
+				}
+			}
+		}
+
+	private:
+		ColorClassifier* m_classifier;
+	};
+
+	/**
+	 * @brief	Classifies a range of rows
+	 */
+	class ColorClassifierBody : public cv::ParallelLoopBody
+	{
+	public:
+		ColorClassifierBody(const ColorClassifier* p_classifier, const cv::Mat* p_image, cv::Mat* p_mask)
+		{
+			m_classifier = p_classifier;
+			m_image = p_image;
+			m_mask = p_mask;
+		}
+
+		void operator()(const cv::Range& p_range) const
+		{
+			for (int y = p_range.start; y < p_range.end; ++y)
+			{
+				if (m_classifier->m_useAvx2)
+				{
+					m_classifier->ClassifyRowAvx2(m_image->ptr<unsigned char>(y), m_mask->ptr<unsigned char>(y), m_image->cols);
+				}
+				else
+				{
+					m_classifier->ClassifyRowScalar(m_image->ptr<unsigned char>(y), m_mask->ptr<unsigned char>(y), m_image->cols);
+				}
+			}
+		}
+
+	private:
+		const ColorClassifier* m_classifier;
+		const cv::Mat* m_image;
+		cv::Mat* m_mask;
+	};
+
+	ColorClassifier::ColorClassifier()
+	{
+		m_ready = false;
+		m_hasAvx2 = DetectAvx2();
+		m_useAvx2 = m_hasAvx2;
+
+		for (int i = 0; i < 256; ++i)
+		{
+			unsigned long long expanded = 0;
+			for (int bit = 0; bit < 8; ++bit)
+			{
+				if (i & (1 << bit))
+				{
+					expanded |= (0xFFull << (bit * 8));
+				}
+			}
+			m_expand[i] = expanded;
+		}
+	}
+
+	ColorClassifier::~ColorClassifier()
+	{
+	}
+
+	void ColorClassifier::SetRange(cv::Scalar p_lower, cv::Scalar p_upper)
+	{
+		if (!m_ready || p_lower != m_lower || p_upper != m_upper)
+		{
+			m_lower = p_lower;
+			m_upper = p_upper;
+			BuildTable();
+			m_ready = true;
+		}
+	}
+
+	void ColorClassifier::BuildTable()
+	{
+		m_table.resize((1 << 24) / 32);
+		cv::parallel_for_(cv::Range(0, 256), ColorTableBody(this));
+	}
+
+	void ColorClassifier::Classify(const cv::Mat& p_image, cv::Mat& p_mask)
+	{
+		CV_Assert(p_image.type() == CV_8UC3 && m_ready);
+		p_mask.create(p_image.size(), CV_8UC1);
+		cv::parallel_for_(cv::Range(0, p_image.rows), ColorClassifierBody(this, &p_image, &p_mask));
+	}
+
+	bool ColorClassifier::IsReady()
+	{
+		return m_ready;
+	}
+
+	bool ColorClassifier::IsUsingAvx2()
+	{
+		return m_useAvx2;
+	}
+
+	void ColorClassifier::SetUseAvx2(bool p_useAvx2)
+	{
+		m_useAvx2 = (p_useAvx2 && m_hasAvx2);
+	}
+
+	void ColorClassifier::ClassifyRowScalar(const unsigned char* p_source, unsigned char* p_destination, int p_width) const
+	{
+		const unsigned int* table = &m_table[0];
+		for (int x = 0; x < p_width; ++x)
+		{
+			unsigned int index = (p_source[(x * 3) + 0] << 16) | (p_source[(x * 3) + 1] << 8) | p_source[(x * 3) + 2];
+			p_destination[x] = ((table[index >> 5] >> (index & 31)) & 1) ? 255 : 0;
+		}
+	}
+
+	KB06_AVX2_TARGET
+	void ColorClassifier::ClassifyRowAvx2(const unsigned char* p_source, unsigned char* p_destination, int p_width) const
+	{
+		const int* table = reinterpret_cast<const int*>(&m_table[0]);
+		// Turns 4 BGR pixels per lane into 4 dwords holding (b << 16) | (g << 8) | r
+		const __m256i shuffle = _mm256_setr_epi8(
+				2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1,
+				2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1);
+		const __m256i bitMask = _mm256_set1_epi32(31);
+
+		int x = 0;
+		// The second load reads 16 bytes from pixel 4, so stop before it reads past the row
+		for (; (x + 10) <= p_width; x += 8)
+		{
+			const unsigned char* source = (p_source + (x * 3));
+			__m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source));
+			__m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + 12));
+			__m256i pixels = _mm256_inserti128_si256(_mm256_castsi128_si256(low), high, 1);
+			__m256i indices = _mm256_shuffle_epi8(pixels, shuffle);
+
+			__m256i words = _mm256_i32gather_epi32(table, _mm256_srli_epi32(indices, 5), 4);
+			__m256i bits = _mm256_srlv_epi32(words, _mm256_and_si256(indices, bitMask));
+			int mask = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_slli_epi32(bits, 31)));
+
+			std::memcpy((p_destination + x), &m_expand[mask], 8);
+		}
+
+		ClassifyRowScalar((p_source + (x * 3)), (p_destination + x), (p_width - x));
+	}
+
+	bool ColorClassifier::DetectAvx2()
+	{
+#if defined(_MSC_VER)
+		int info[4];
+		__cpuid(info, 0);
+		if (info[0] < 7)
+		{
+			return false;
+		}
+
+		__cpuid(info, 1);
+		bool osxsave = ((info[2] & (1 << 27)) != 0);
+		bool avx = ((info[2] & (1 << 28)) != 0);
+		if (!osxsave || !avx || ((_xgetbv(0) & 6) != 6))
+		{
+			return false;
+		}
+
+		__cpuidex(info, 7, 0);
+		return ((info[1] & (1 << 5)) != 0);
+#elif defined(__GNUC__)
+		__builtin_cpu_init();
+		return (__builtin_cpu_supports("avx2") != 0);
+#else
+		return false;
+#endif
+	}
+}
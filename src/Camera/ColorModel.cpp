@@ -0,0 +1,68 @@
+#include "Camera/ColorModel.h"
+
+namespace Camera
+{
+	ColorModel::ColorModel()
+	{
+		m_histogram = cv::Mat::zeros(C_HUE_BINS, C_SATURATION_BINS, CV_32F);
+		m_ready = false;
+		m_threshold = 40;
+	}
+
+	ColorModel::~ColorModel()
+	{
+	}
+
+	void ColorModel::Reset()
+	{
+		m_histogram.setTo(cv::Scalar(0));
+		m_ready = false;
+	}
+
+	bool ColorModel::IsReady()
+	{
+		return m_ready;
+	}
+
+	void ColorModel::Learn(const cv::Mat& p_hsv, const cv::Mat& p_mask, float p_rate)
+	{
+		const int channels[] = { 0, 1 };
+		const int bins[] = { C_HUE_BINS, C_SATURATION_BINS };
+		const float hueRange[] = { 0.0f, 180.0f };
+		const float saturationRange[] = { 0.0f, 256.0f };
+		const float* ranges[] = { hueRange, saturationRange };
+
+		cv::calcHist(&p_hsv, 1, channels, p_mask, m_sample, 2, bins, ranges);
+
+		// Let the learned colors bleed into their neighbours, a small sample never covers every shade
+		cv::GaussianBlur(m_sample, m_sample, cv::Size(3, 3), 0.0);
+		// Scale so the most common color back-projects to 255
+		cv::normalize(m_sample, m_sample, 0.0, 255.0, cv::NORM_MINMAX);
+
+		if (!m_ready || p_rate >= 1.0f)
+		{
+			m_sample.copyTo(m_histogram);
+			m_ready = true;
+		}
+		else
+		{
+			cv::addWeighted(m_histogram, (1.0 - p_rate), m_sample, p_rate, 0.0, m_histogram);
+		}
+	}
+
+	void ColorModel::Segment(const cv::Mat& p_hsv, cv::Mat& p_mask)
+	{
+		const int channels[] = { 0, 1 };
+		const float hueRange[] = { 0.0f, 180.0f };
+		const float saturationRange[] = { 0.0f, 256.0f };
+		const float* ranges[] = { hueRange, saturationRange };
+
+		cv::calcBackProject(&p_hsv, 1, channels, m_histogram, p_mask, ranges);
+		cv::threshold(p_mask, p_mask, m_threshold, 255, cv::THRESH_BINARY);
+	}
+
+	void ColorModel::SetThreshold(int p_threshold)
+	{
+		m_threshold = p_threshold;
+	}
+}
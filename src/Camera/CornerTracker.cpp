@@ -0,0 +1,148 @@
+#include "Camera/CornerTracker.h"
+
+namespace Camera
+{
+	CornerTracker::CornerTracker()
+	{
+		m_tracking = false;
+		m_maxError = 1.0f;
+		m_lastError = 0.0f;
+		m_area = 0.0;
+		m_windowSize = cv::Size(21, 21);
+		m_maxLevel = 3;
+		m_margin = 48;
+	}
+
+	CornerTracker::~CornerTracker()
+	{
+		m_previousWindow.release();
+		m_window.release();
+	}
+
+	void CornerTracker::Start(const cv::Mat& p_image, const std::vector<cv::Point2f>& p_corners)
+	{
+		m_corners = p_corners;
+		m_area = std::fabs(cv::contourArea(m_corners));
+		m_previousRegion = GetRegion(p_image.size());
+		ConvertWindow(p_image, m_previousRegion, m_previousWindow);
+		m_lastError = 0.0f;
+		m_tracking = (m_previousRegion.area() > 0);
+	}
+
+	bool CornerTracker::Track(const cv::Mat& p_image, std::vector<cv::Point2f>& p_corners)
+	{
+		if (!m_tracking)
+		{
+			return false;
+		}
+
+		// The corners moved little since the last frame, so they are searched in the same window
+		cv::Rect region = m_previousRegion;
+		ConvertWindow(p_image, region, m_window);
+
+		std::vector<cv::Point2f> previous = m_corners;
+		for (unsigned int i = 0; i < previous.size(); ++i)
+		{
+			previous[i] -= cv::Point2f(static_cast<float>(region.x), static_cast<float>(region.y));
+		}
+
+		cv::TermCriteria criteria = cv::TermCriteria(cv::TermCriteria::COUNT | cv::TermCriteria::EPS, 20, 0.03);
+		std::vector<cv::Point2f> next;
+		std::vector<cv::Point2f> back;
+		std::vector<unsigned char> status;
+		std::vector<unsigned char> backStatus;
+		std::vector<float> error;
+
+		cv::calcOpticalFlowPyrLK(m_previousWindow, m_window, previous, next, status, error, m_windowSize, m_maxLevel, criteria);
+		cv::calcOpticalFlowPyrLK(m_window, m_previousWindow, next, back, backStatus, error, m_windowSize, m_maxLevel, criteria);
+
+		// Every corner has to be found and return to where it started
+		cv::Rect inside = cv::Rect(3, 3, (region.width - 6), (region.height - 6));
+		m_lastError = 0.0f;
+		for (unsigned int i = 0; i < next.size(); ++i)
+		{
+			if (!status[i] || !backStatus[i] || !inside.contains(next[i]))
+			{
+				Reset();
+				return false;
+			}
+
+			cv::Point2f difference = back[i] - previous[i];
+			m_lastError = std::max(m_lastError, std::sqrt((difference.x * difference.x) + (difference.y * difference.y)));
+		}
+
+		if (m_lastError > m_maxError)
+		{
+			Reset();
+			return false;
+		}
+
+		cv::cornerSubPix(m_window, next, cv::Size(3, 3), cv::Size(-1, -1), criteria);
+
+		// The surface can not fold or suddenly change size between two frames
+		double area = std::fabs(cv::contourArea(next));
+		if (!cv::isContourConvex(next) || area < (m_area * 0.7) || area > (m_area * 1.4))
+		{
+			Reset();
+			return false;
+		}
+
+		for (unsigned int i = 0; i < next.size(); ++i)
+		{
+			next[i] += cv::Point2f(static_cast<float>(region.x), static_cast<float>(region.y));
+		}
+		m_corners = next;
+		m_area = area;
+		p_corners = m_corners;
+
+		// Keep the window of this frame for the next one, only convert again when the window moved
+		m_previousRegion = GetRegion(p_image.size());
+		if (m_previousRegion == region)
+		{
+			cv::swap(m_previousWindow, m_window);
+		}
+		else
+		{
+			ConvertWindow(p_image, m_previousRegion, m_previousWindow);
+		}
+
+		return true;
+	}
+
+	void CornerTracker::Reset()
+	{
+		m_tracking = false;
+		m_corners.clear();
+	}
+
+	bool CornerTracker::IsTracking()
+	{
+		return m_tracking;
+	}
+
+	void CornerTracker::SetMaxError(float p_maxError)
+	{
+		m_maxError = p_maxError;
+	}
+
+	float CornerTracker::GetLastError()
+	{
+		return m_lastError;
+	}
+
+	cv::Rect CornerTracker::GetRegion(cv::Size p_imageSize)
+	{
+		cv::Rect region = cv::boundingRect(m_corners);
+		region.x -= m_margin;
+		region.y -= m_margin;
+		region.width += (m_margin * 2);
+		region.height += (m_margin * 2);
+
+		return (region & cv::Rect(0, 0, p_imageSize.width, p_imageSize.height));
+	}
+
+	void CornerTracker::ConvertWindow(const cv::Mat& p_image, cv::Rect p_region, cv::Mat& p_window)
+	{
+		cv::cvtColor(p_image(p_region), p_window, CV_BGR2GRAY);
+	}
+}
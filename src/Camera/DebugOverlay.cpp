@@ -0,0 +1,298 @@
+#include "Camera/DebugOverlay.h"
+
+namespace Camera
+{
+	DebugOverlay* DebugOverlay::m_debugOverlay = NULL;
+	const char* DebugOverlay::C_WINDOW_NAME = "debug overlay";
+
+	DebugOverlay::DebugOverlay()
+	{
+		m_output = OUTPUT_NONE;
+		m_directory = ".";
+		for (unsigned int i = 0; i < C_CAPACITY; ++i)
+		{
+			m_slots[i].m_sequence.store(i);
+		}
+		m_tail = 0;
+		m_head = 0;
+		m_dropped = 0;
+		m_windowOpened = false;
+		m_written = 0;
+	}
+
+	DebugOverlay::~DebugOverlay()
+	{
+		if (m_windowOpened)
+		{
+			cv::destroyWindow(C_WINDOW_NAME);
+		}
+	}
+
+	DebugOverlay* DebugOverlay::GetInstance()
+	{
+		if (m_debugOverlay == NULL)
+		{
+			m_debugOverlay = new DebugOverlay();
+		}
+
+		return m_debugOverlay;
+	}
+
+	void DebugOverlay::ResetInstance()
+	{
+		delete m_debugOverlay;
+		m_debugOverlay = NULL;
+	}
+
+	void DebugOverlay::SetOutput(Output p_output)
+	{
+		m_output = p_output;
+	}
+
+	DebugOverlay::Output DebugOverlay::GetOutput()
+	{
+		return static_cast<Output>(m_output.load());
+	}
+
+	bool DebugOverlay::IsEnabled()
+	{
+		return (m_output.load(std::memory_order_relaxed) != OUTPUT_NONE);
+	}
+
+	void DebugOverlay::SetDirectory(const std::string& p_directory)
+	{
+		m_directory = p_directory;
+	}
+
+	void DebugOverlay::Clear(Source p_source)
+	{
+		if (IsEnabled())
+		{
+			Push(MakePrimitive(TYPE_CLEAR, p_source, cv::Scalar()));
+		}
+	}
+
+	void DebugOverlay::AddPoint(Source p_source, cv::Point2f p_point, cv::Size p_imageSize, cv::Scalar p_color, float p_radius)
+	{
+		if (!IsEnabled() || p_imageSize.area() == 0)
+		{
+			return;
+		}
+
+		Primitive primitive = MakePrimitive(TYPE_POINT, p_source, p_color);
+		primitive.m_x1 = (p_point.x / p_imageSize.width);
+		primitive.m_y1 = (p_point.y / p_imageSize.height);
+		primitive.m_radius = (p_radius / p_imageSize.width);
+		Push(primitive);
+	}
+
+	void DebugOverlay::AddLine(Source p_source, cv::Point2f p_start, cv::Point2f p_end, cv::Size p_imageSize, cv::Scalar p_color)
+	{
+		if (!IsEnabled() || p_imageSize.area() == 0)
+		{
+			return;
+		}
+
+		Primitive primitive = MakePrimitive(TYPE_LINE, p_source, p_color);
+		primitive.m_x1 = (p_start.x / p_imageSize.width);
+		primitive.m_y1 = (p_start.y / p_imageSize.height);
+		primitive.m_x2 = (p_end.x / p_imageSize.width);
+		primitive.m_y2 = (p_end.y / p_imageSize.height);
+		Push(primitive);
+	}
+
+	void DebugOverlay::AddRectangle(Source p_source, cv::Rect p_rectangle, cv::Size p_imageSize, cv::Scalar p_color)
+	{
+		if (!IsEnabled() || p_imageSize.area() == 0)
+		{
+			return;
+		}
+
+		Primitive primitive = MakePrimitive(TYPE_RECTANGLE, p_source, p_color);
+		primitive.m_x1 = (static_cast<float>(p_rectangle.x) / p_imageSize.width);
+		primitive.m_y1 = (static_cast<float>(p_rectangle.y) / p_imageSize.height);
+		primitive.m_x2 = (static_cast<float>(p_rectangle.br().x) / p_imageSize.width);
+		primitive.m_y2 = (static_cast<float>(p_rectangle.br().y) / p_imageSize.height);
+		Push(primitive);
+	}
+
+	void DebugOverlay::AddLabel(Source p_source, const std::string& p_text, cv::Point2f p_position, cv::Size p_imageSize, cv::Scalar p_color)
+	{
+		if (!IsEnabled() || p_imageSize.area() == 0)
+		{
+			return;
+		}
+
+		Primitive primitive = MakePrimitive(TYPE_LABEL, p_source, p_color);
+		primitive.m_x1 = (p_position.x / p_imageSize.width);
+		primitive.m_y1 = (p_position.y / p_imageSize.height);
+		size_t length = std::min(p_text.size(), (sizeof(primitive.m_label) - 1));
+		memcpy(primitive.m_label, p_text.c_str(), length);
+		primitive.m_label[length] = '\0';
+		Push(primitive);
+	}
+
+	bool DebugOverlay::Update()
+	{
+		bool changed = false;
+		for (;;)
+		{
+			Slot& slot = m_slots[m_head & (C_CAPACITY - 1)];
+			unsigned int sequence = slot.m_sequence.load(std::memory_order_acquire);
+			if (static_cast<int>(sequence - (m_head + 1)) < 0)
+			{
+				// Nothing was written here yet
+				break;
+			}
+
+			const Primitive& primitive = slot.m_primitive;
+			if (primitive.m_type == TYPE_CLEAR)
+			{
+				size_t kept = 0;
+				for (size_t i = 0; i < m_primitives.size(); ++i)
+				{
+					if (m_primitives[i].m_source != primitive.m_source)
+					{
+						m_primitives[kept++] = m_primitives[i];
+					}
+				}
+				m_primitives.resize(kept);
+			}
+			else
+			{
+				m_primitives.push_back(primitive);
+			}
+			changed = true;
+
+			// The slot can be written again once the ring has gone around
+			slot.m_sequence.store((m_head + C_CAPACITY), std::memory_order_release);
+			++m_head;
+		}
+		return changed;
+	}
+
+	const std::vector<DebugOverlay::Primitive>& DebugOverlay::GetPrimitives()
+	{
+		return m_primitives;
+	}
+
+	void DebugOverlay::Draw(cv::Mat& p_image)
+	{
+		float width = static_cast<float>(p_image.cols);
+		float height = static_cast<float>(p_image.rows);
+		for (size_t i = 0; i < m_primitives.size(); ++i)
+		{
+			const Primitive& primitive = m_primitives[i];
+			cv::Scalar color = cv::Scalar(primitive.m_blue, primitive.m_green, primitive.m_red);
+			cv::Point start = cv::Point(cvRound(primitive.m_x1 * width), cvRound(primitive.m_y1 * height));
+			cv::Point end = cv::Point(cvRound(primitive.m_x2 * width), cvRound(primitive.m_y2 * height));
+			switch (primitive.m_type)
+			{
+			case TYPE_POINT:
+				cv::circle(p_image, start, std::max(1, cvRound(primitive.m_radius * width)), color);
+				break;
+			case TYPE_LINE:
+				cv::line(p_image, start, end, color);
+				break;
+			case TYPE_RECTANGLE:
+				cv::rectangle(p_image, start, end, color);
+				break;
+			case TYPE_LABEL:
+				cv::putText(p_image, primitive.m_label, start, cv::FONT_HERSHEY_PLAIN, 1.0, color);
+				break;
+			default:
+				break;
+			}
+		}
+	}
+
+	void DebugOverlay::Show(const cv::Mat& p_frame, bool p_changed)
+	{
+		Output output = GetOutput();
+		if (p_frame.empty() || (output != OUTPUT_WINDOW && output != OUTPUT_DISK))
+		{
+			return;
+		}
+		if (output == OUTPUT_DISK && !p_changed)
+		{
+			return;
+		}
+
+		// The frame belongs to the capture, the primitives go on a copy of it
+		p_frame.copyTo(m_canvas);
+		Draw(m_canvas);
+
+		if (output == OUTPUT_WINDOW)
+		{
+			cv::imshow(C_WINDOW_NAME, m_canvas);
+			cv::waitKey(1);
+			m_windowOpened = true;
+			return;
+		}
+
+		std::ostringstream path;
+		path << m_directory << "/overlay_" << std::setw(6) << std::setfill('0') << m_written << ".png";
+		if (!cv::imwrite(path.str(), m_canvas))
+		{
+			std::string message = "DebugOverlay: Could not write " + path.str() + ", going back to no output";
+			Utility::Logger::GetInstance()->Log(Utility::Logger::LOG_ERROR, message.c_str());
+			SetOutput(OUTPUT_NONE);
+			return;
+		}
+		++m_written;
+	}
+
+	unsigned long DebugOverlay::GetDroppedCount()
+	{
+		return m_dropped;
+	}
+
+	DebugOverlay::Primitive DebugOverlay::MakePrimitive(Type p_type, Source p_source, cv::Scalar p_color)
+	{
+		Primitive primitive;
+		primitive.m_type = p_type;
+		primitive.m_source = p_source;
+		primitive.m_x1 = 0.0f;
+		primitive.m_y1 = 0.0f;
+		primitive.m_x2 = 0.0f;
+		primitive.m_y2 = 0.0f;
+		primitive.m_radius = 0.0f;
+		primitive.m_blue = cv::saturate_cast<unsigned char>(p_color.val[0]);
+		primitive.m_green = cv::saturate_cast<unsigned char>(p_color.val[1]);
+		primitive.m_red = cv::saturate_cast<unsigned char>(p_color.val[2]);
+		primitive.m_label[0] = '\0';
+		return primitive;
+	}
+
+	void DebugOverlay::Push(const Primitive& p_primitive)
+	{
+		// Claims a slot; a slot whose sequence is behind the position is still waiting for the render thread
+		unsigned int position = m_tail.load(std::memory_order_relaxed);
+		Slot* slot = NULL;
+		for (;;)
+		{
+			slot = &m_slots[position & (C_CAPACITY - 1)];
+			int difference = static_cast<int>(slot->m_sequence.load(std::memory_order_acquire) - position);
+			if (difference == 0)
+			{
+				if (m_tail.compare_exchange_weak(position, (position + 1), std::memory_order_relaxed))
+				{
+					break;
+				}
+			}
+			else if (difference < 0)
+			{
+				// Full, the detector does not wait for the render thread
+				++m_dropped;
+				return;
+			}
+			else
+			{
+				position = m_tail.load(std::memory_order_relaxed);
+			}
+		}
+
+		slot->m_primitive = p_primitive;
+		slot->m_sequence.store((position + 1), std::memory_order_release);
+	}
+}
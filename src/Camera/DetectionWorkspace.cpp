@@ -0,0 +1,142 @@
+#include "Camera/DetectionWorkspace.h"
+
+namespace Camera
+{
+	DetectionWorkspace::DetectionWorkspace()
+	{
+		m_storage = cvCreateMemStorage(0);
+		m_points.reserve(4096);
+		m_contourStarts.reserve(256);
+		m_curve.reserve(1024);
+		m_approx.reserve(64);
+		m_reallocations = 0;
+		Begin();
+	}
+
+	DetectionWorkspace::~DetectionWorkspace()
+	{
+		cvReleaseMemStorage(&m_storage);
+	}
+
+	void DetectionWorkspace::Begin()
+	{
+		for (int buffer = 0; buffer < BUFFER_COUNT; ++buffer)
+		{
+			m_imageData[buffer] = m_images[buffer].data;
+		}
+		m_pointsCapacity = m_points.capacity();
+		m_contourStartsCapacity = m_contourStarts.capacity();
+		m_curveCapacity = m_curve.capacity();
+		m_approxCapacity = m_approx.capacity();
+		m_storageBlocks = CountStorageBlocks();
+	}
+
+	void DetectionWorkspace::End()
+	{
+		bool reallocated = (m_pointsCapacity != m_points.capacity() ||
+				m_contourStartsCapacity != m_contourStarts.capacity() ||
+				m_curveCapacity != m_curve.capacity() ||
+				m_approxCapacity != m_approx.capacity() ||
+				m_storageBlocks != CountStorageBlocks());
+		for (int buffer = 0; buffer < BUFFER_COUNT; ++buffer)
+		{
+			reallocated |= (m_imageData[buffer] != m_images[buffer].data);
+		}
+
+		if (reallocated)
+		{
+			++m_reallocations;
+		}
+	}
+
+	cv::Mat DetectionWorkspace::GetImage(Buffer p_buffer, cv::Size p_size, int p_type)
+	{
+		size_t bytes = (static_cast<size_t>(p_size.area()) * CV_ELEM_SIZE(p_type));
+		if (bytes == 0)
+		{
+			return cv::Mat();
+		}
+
+		cv::Mat& storage = m_images[p_buffer];
+		if (storage.total() < bytes)
+		{
+			// Grow to the largest image seen so far, so alternating sizes do not keep reallocating
+			storage.create(1, static_cast<int>(bytes), CV_8UC1);
+		}
+		// A continuous image of exactly the asked size at the start of the buffer, not a view on a larger image:
+		// filters read the pixels around a view, which would be whatever a larger image left behind
+		return cv::Mat(p_size, p_type, storage.data);
+	}
+
+	int DetectionWorkspace::FindContours(cv::Mat& p_image, cv::Point p_offset)
+	{
+		// The blocks of the storage are kept, so clearing it does not free anything
+		cvClearMemStorage(m_storage);
+		m_points.clear();
+		m_contourStarts.clear();
+
+		CvMat image = p_image;
+		CvSeq* first = NULL;
+		cvFindContours(&image, m_storage, &first, sizeof(CvContour), CV_RETR_LIST, CV_CHAIN_APPROX_SIMPLE, p_offset);
+
+		for (CvSeq* contour = first; contour != NULL; contour = contour->h_next)
+		{
+			size_t start = m_points.size();
+			m_contourStarts.push_back(static_cast<int>(start));
+			m_points.resize(start + contour->total);
+			if (contour->total > 0)
+			{
+				cvCvtSeqToArray(contour, &m_points[start]);
+			}
+		}
+		m_contourStarts.push_back(static_cast<int>(m_points.size()));
+
+		return static_cast<int>(m_contourStarts.size() - 1);
+	}
+
+	cv::Mat DetectionWorkspace::GetContour(int p_index)
+	{
+		int start = m_contourStarts[p_index];
+		int count = (m_contourStarts[p_index + 1] - start);
+		if (count == 0)
+		{
+			return cv::Mat();
+		}
+		return cv::Mat(count, 1, CV_32SC2, &m_points[start]);
+	}
+
+	std::vector<cv::Point2f>& DetectionWorkspace::ApproximateContour(int p_index)
+	{
+		int start = m_contourStarts[p_index];
+		int end = m_contourStarts[p_index + 1];
+
+		// Converted by hand, a cv::Mat conversion would allocate a new matrix for every contour
+		m_curve.resize(end - start);
+		for (int i = start; i < end; ++i)
+		{
+			m_curve[i - start] = cv::Point2f(static_cast<float>(m_points[i].x), static_cast<float>(m_points[i].y));
+		}
+
+		m_approx.clear();
+		if (!m_curve.empty())
+		{
+			cv::approxPolyDP(m_curve, m_approx, (cv::arcLength(m_curve, true) * 0.02), true);
+		}
+		return m_approx;
+	}
+
+	unsigned long DetectionWorkspace::GetReallocationCount()
+	{
+		return m_reallocations;
+	}
+
+	int DetectionWorkspace::CountStorageBlocks()
+	{
+		int blocks = 0;
+		for (CvMemBlock* block = m_storage->bottom; block != NULL; block = block->next)
+		{
+			++blocks;
+		}
+		return blocks;
+	}
+}
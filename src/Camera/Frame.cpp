@@ -0,0 +1,39 @@
+#include "Camera/Frame.h"
+
+namespace Camera
+{
+	Frame::Frame()
+	{
+		m_sequence = 0;
+		m_timestamp = 0.0;
+		m_acquiredTicks = 0;
+		m_backgroundUpdated = false;
+		m_lost = true;
+		m_pixelDistance = 100.0f;
+		m_lineRatio = 0.0f;
+		m_transformation = irr::core::IdentityMatrix;
+		m_velocity = irr::core::vector3df(0.0f, 0.0f, 0.0f);
+		m_angularVelocity = cv::Vec3d(0.0, 0.0, 0.0);
+		m_analysis = 0;
+	}
+
+	void Frame::MoveFrom(Frame& p_other)
+	{
+		cv::swap(m_image, p_other.m_image);
+		cv::swap(m_background, p_other.m_background);
+		cv::swap(m_textureImage, p_other.m_textureImage);
+
+		m_timestamp = p_other.m_timestamp;
+		m_acquiredTicks = p_other.m_acquiredTicks;
+		m_backgroundUpdated = p_other.m_backgroundUpdated;
+		m_imageCorners = p_other.m_imageCorners;
+		m_corners = p_other.m_corners;
+		m_lost = p_other.m_lost;
+		m_pixelDistance = p_other.m_pixelDistance;
+		m_lineRatio = p_other.m_lineRatio;
+		m_transformation = p_other.m_transformation;
+		m_velocity = p_other.m_velocity;
+		m_angularVelocity = p_other.m_angularVelocity;
+		m_analysis = p_other.m_analysis;
+	}
+}
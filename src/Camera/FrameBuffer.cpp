@@ -0,0 +1,74 @@
+#include "Camera/FrameBuffer.h"
+
+namespace Camera
+{
+	FrameBuffer::FrameBuffer()
+	{
+		m_back = 0;
+		m_middle = 1;
+		m_front = 2;
+		m_published = 0;
+		m_dropped = 0;
+		m_reused = 0;
+	}
+
+	FrameBuffer::~FrameBuffer()
+	{
+		for (int i = 0; i < 3; ++i)
+		{
+			m_frames[i].m_image.release();
+		}
+	}
+
+	Frame& FrameBuffer::GetBackFrame()
+	{
+		return m_frames[m_back];
+	}
+
+	void FrameBuffer::Publish()
+	{
+		m_frames[m_back].m_sequence = ++m_published;
+
+		// Swap the back frame with the middle frame and mark the middle as fresh
+		int previous = m_middle.exchange(m_back | C_FRESH);
+		if (previous & C_FRESH)
+		{
+			++m_dropped;
+		}
+
+		m_back = (previous & C_INDEX_MASK);
+	}
+
+	bool FrameBuffer::Acquire()
+	{
+		if ((m_middle.load() & C_FRESH) == 0)
+		{
+			++m_reused;
+			return false;
+		}
+
+		// Swap the front frame with the middle frame, the middle is no longer fresh afterwards
+		m_front = (m_middle.exchange(m_front) & C_INDEX_MASK);
+		return true;
+	}
+
+	const Frame& FrameBuffer::GetFrontFrame()
+	{
+		return m_frames[m_front];
+	}
+
+	unsigned long FrameBuffer::GetPublishedCount()
+	{
+		return m_published;
+	}
+
+	unsigned long FrameBuffer::GetDroppedCount()
+	{
+		return m_dropped;
+	}
+
+	unsigned long FrameBuffer::GetReusedCount()
+	{
+		return m_reused;
+	}
+}
@@ -0,0 +1,165 @@
+#include "Camera/FrameQueue.h"
+
+namespace Camera
+{
+	FrameQueue::FrameQueue(int p_depth)
+	{
+		m_depth = std::max(p_depth, 1);
+		// Besides the waiting frames the producer owns one, and the consumer two while it skips frames
+		m_frames.resize(m_depth + 3);
+		m_queued = new std::atomic<int>[m_depth];
+		m_free.resize(m_frames.size());
+		m_head = 0;
+		m_tail = 0;
+
+		m_write = 0;
+		m_read = -1;
+		m_freeTail = 0;
+		m_freeHead = 0;
+		for (unsigned int i = 1; i < m_frames.size(); ++i)
+		{
+			m_free[m_freeHead] = i;
+			++m_freeHead;
+		}
+
+		m_pushed = 0;
+		m_dropped = 0;
+		m_depthSum = 0;
+	}
+
+	FrameQueue::~FrameQueue()
+	{
+		delete[] m_queued;
+		m_frames.clear();
+	}
+
+	Frame& FrameQueue::GetWriteFrame()
+	{
+		return m_frames[m_write];
+	}
+
+	void FrameQueue::Push()
+	{
+		unsigned int head = m_head.load();
+		unsigned int waiting = (head - m_tail.load());
+		m_depthSum += waiting;
+		++m_pushed;
+
+		// Make room by dropping the oldest frame, the producer reuses it as its next write frame
+		int next = -1;
+		if (waiting >= static_cast<unsigned int>(m_depth) && TakeOldest(next))
+		{
+			++m_dropped;
+		}
+
+		m_queued[head % m_depth] = m_write;
+		m_head.store(head + 1);
+
+		{
+			std::lock_guard<std::mutex> lock(m_waitMutex);
+		}
+		m_waitCondition.notify_one();
+
+		if (next < 0)
+		{
+			// There is always a free frame, unless the consumer is in the middle of skipping frames
+			while (m_freeTail.load() == m_freeHead.load())
+			{
+				std::this_thread::yield();
+			}
+
+			unsigned int freeTail = m_freeTail.load();
+			next = m_free[freeTail % m_free.size()];
+			m_freeTail.store(freeTail + 1);
+		}
+		m_write = next;
+	}
+
+	bool FrameQueue::Pop()
+	{
+		int newest = -1;
+		int index;
+		while (TakeOldest(index))
+		{
+			if (newest >= 0)
+			{
+				// A newer frame is waiting, so this one is never used
+				Release(newest);
+				++m_dropped;
+			}
+			newest = index;
+		}
+
+		if (newest < 0)
+		{
+			return false;
+		}
+
+		if (m_read >= 0)
+		{
+			Release(m_read);
+		}
+		m_read = newest;
+
+		return true;
+	}
+
+	void FrameQueue::Wait(int p_milliseconds)
+	{
+		std::unique_lock<std::mutex> lock(m_waitMutex);
+		m_waitCondition.wait_for(lock, std::chrono::milliseconds(p_milliseconds), [this]()
+		{
+			return (m_head.load() != m_tail.load());
+		});
+	}
+
+	Frame& FrameQueue::GetReadFrame()
+	{
+		return m_frames[m_read];
+	}
+
+	int FrameQueue::GetDepth()
+	{
+		return m_depth;
+	}
+
+	unsigned long FrameQueue::GetPushedCount()
+	{
+		return m_pushed;
+	}
+
+	unsigned long FrameQueue::GetDroppedCount()
+	{
+		return m_dropped;
+	}
+
+	double FrameQueue::GetAverageDepth()
+	{
+		unsigned long pushed = m_pushed;
+		return ((pushed > 0) ? (static_cast<double>(m_depthSum) / pushed) : 0.0);
+	}
+
+	bool FrameQueue::TakeOldest(int& p_index)
+	{
+		unsigned int tail = m_tail.load();
+		while (tail != m_head.load())
+		{
+			// The index is only valid when nobody else took the frame in the meantime
+			int index = m_queued[tail % m_depth];
+			if (m_tail.compare_exchange_weak(tail, (tail + 1)))
+			{
+				p_index = index;
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	void FrameQueue::Release(int p_index)
+	{
+		unsigned int freeHead = m_freeHead.load();
+		m_free[freeHead % m_free.size()] = p_index;
+		m_freeHead.store(freeHead + 1);
+	}
+}
@@ -0,0 +1,43 @@
+#include "Camera/FrameSource.h"
+#include "Camera/CameraSource.h"
+#include "Camera/VideoSource.h"
+#include "Camera/V4L2Source.h"
+
+namespace Camera
+{
+	FrameSource::~FrameSource()
+	{
+	}
+
+	bool FrameSource::IsFrameReady()
+	{
+		return IsOpened();
+	}
+
+	bool FrameSource::SetSize(cv::Size p_size)
+	{
+		return (GetSize() == p_size);
+	}
+
+	FrameSource* FrameSource::Create(std::string p_description)
+	{
+		if (p_description.empty() || p_description == "camera")
+		{
+			return new CameraSource(CV_CAP_ANY);
+		}
+
+		if (p_description.compare(0, 7, "camera:") == 0)
+		{
+			return new CameraSource(atoi(p_description.substr(7).c_str()));
+		}
+
+#ifdef __linux__
+		if (p_description.compare(0, 5, "v4l2:") == 0)
+		{
+			return new V4L2Source(p_description.substr(5));
+		}
+#endif
+
+		return new VideoSource(p_description);
+	}
+}
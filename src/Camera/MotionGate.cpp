@@ -0,0 +1,74 @@
+#include "Camera/MotionGate.h"
+
+namespace Camera
+{
+	MotionGate::MotionGate()
+	{
+		m_hasReference = false;
+		m_unchangedFrames = 0;
+		m_refreshInterval = 30;
+		m_threshold = 200.0;
+		m_lastDifference = 0.0;
+		m_skipped = 0;
+	}
+
+	MotionGate::~MotionGate()
+	{
+	}
+
+	bool MotionGate::HasChanged(const cv::Mat& p_image)
+	{
+		// Shrink before converting, the conversion then only touches the thumbnail
+		cv::Size size = cv::Size(std::max(1, (p_image.cols / C_SCALE)), std::max(1, (p_image.rows / C_SCALE)));
+		cv::resize(p_image, m_scaled, size, 0.0, 0.0, cv::INTER_AREA);
+		cv::cvtColor(m_scaled, m_thumbnail, CV_BGR2GRAY);
+
+		bool changed = (!m_hasReference || m_reference.size() != m_thumbnail.size() || ++m_unchangedFrames >= m_refreshInterval);
+		if (!changed)
+		{
+			cv::absdiff(m_thumbnail, m_reference, m_difference);
+			cv::threshold(m_difference, m_difference, C_NOISE, 0, cv::THRESH_TOZERO);
+			m_lastDifference = cv::sum(m_difference)[0];
+			changed = (m_lastDifference > m_threshold);
+		}
+
+		if (changed)
+		{
+			cv::swap(m_reference, m_thumbnail);
+			m_hasReference = true;
+			m_unchangedFrames = 0;
+		}
+		else
+		{
+			++m_skipped;
+		}
+
+		return changed;
+	}
+
+	void MotionGate::Reset()
+	{
+		m_hasReference = false;
+		m_unchangedFrames = 0;
+	}
+
+	void MotionGate::SetThreshold(double p_threshold)
+	{
+		m_threshold = p_threshold;
+	}
+
+	void MotionGate::SetRefreshInterval(int p_refreshInterval)
+	{
+		m_refreshInterval = p_refreshInterval;
+	}
+
+	double MotionGate::GetLastDifference()
+	{
+		return m_lastDifference;
+	}
+
+	unsigned long MotionGate::GetSkippedCount()
+	{
+		return m_skipped;
+	}
+}
@@ -0,0 +1,216 @@
+#include "Camera/PencilTracker.h"
+
+namespace Camera
+{
+	PencilTracker::PencilTracker()
+	{
+		m_matchRatio = 0.5f;
+		m_changeRatio = 0.2f;
+		Reset();
+	}
+
+	PencilTracker::~PencilTracker()
+	{
+	}
+
+	bool PencilTracker::Update(const irr::core::vector3df* p_startPoints, const irr::core::vector3df* p_endPoints, int p_amount, unsigned long p_sequence)
+	{
+		if (m_hasSequence && p_sequence == m_sequence)
+		{
+			// The render loop asks more often than the camera delivers, a frame only gets one vote
+			return false;
+		}
+		m_sequence = p_sequence;
+		m_hasSequence = true;
+		++m_frames;
+
+		for (size_t i = 0; i < m_tracks.size(); ++i)
+		{
+			m_tracks[i].m_matched = false;
+			m_tracks[i].m_votes = ((m_tracks[i].m_votes << 1) & ((1u << C_WINDOW) - 1));
+			m_tracks[i].m_frames = ((m_tracks[i].m_frames < C_WINDOW) ? (m_tracks[i].m_frames + 1) : C_WINDOW);
+		}
+
+		for (int i = 0; (p_startPoints != NULL && p_endPoints != NULL && i < p_amount); ++i)
+		{
+			// The closest pencil that was not found in this frame yet
+			int closest = -1;
+			bool closestSwapped = false;
+			float closestDistance = m_matchRatio;
+			for (size_t j = 0; j < m_tracks.size(); ++j)
+			{
+				bool swapped = false;
+				float distance = Distance(m_tracks[j].m_start, m_tracks[j].m_end, p_startPoints[i], p_endPoints[i], swapped);
+				if (!m_tracks[j].m_matched && distance < closestDistance)
+				{
+					closest = static_cast<int>(j);
+					closestSwapped = swapped;
+					closestDistance = distance;
+				}
+			}
+
+			const irr::core::vector3df& start = (closestSwapped ? p_endPoints[i] : p_startPoints[i]);
+			const irr::core::vector3df& end = (closestSwapped ? p_startPoints[i] : p_endPoints[i]);
+			if (closest < 0)
+			{
+				Track track;
+				track.m_start = start;
+				track.m_end = end;
+				track.m_votes = 1;
+				track.m_frames = 1;
+				track.m_matched = true;
+				m_tracks.push_back(track);
+				continue;
+			}
+
+			// Averages out the jitter of the detection, a pencil that really moved gets there within a few frames
+			Track& track = m_tracks[closest];
+			track.m_start += ((start - track.m_start) * 0.25f);
+			track.m_end += ((end - track.m_end) * 0.25f);
+			track.m_votes |= 1;
+			track.m_matched = true;
+		}
+
+		// Pencils that were not found in the whole window are gone
+		bool stable = true;
+		std::vector<irr::core::vector3df> starts;
+		std::vector<irr::core::vector3df> ends;
+		for (size_t i = 0; i < m_tracks.size();)
+		{
+			Track& track = m_tracks[i];
+			if (track.m_votes == 0 && track.m_frames >= C_WINDOW)
+			{
+				m_tracks.erase(m_tracks.begin() + i);
+				continue;
+			}
+
+			int found = CountVotes(track.m_votes);
+			if (track.m_frames < C_WINDOW || (found < C_MIN_VOTES && found > (C_WINDOW - C_MIN_VOTES)))
+			{
+				// Not voted on long enough, or found too often to leave out and too rarely to keep
+				stable = false;
+			}
+			else if (found >= C_MIN_VOTES)
+			{
+				starts.push_back(track.m_start);
+				ends.push_back(track.m_end);
+			}
+			++i;
+		}
+
+		if (!stable || !HasChanged(starts, ends))
+		{
+			return false;
+		}
+
+		m_layoutStarts = starts;
+		m_layoutEnds = ends;
+		++m_layouts;
+		return true;
+	}
+
+	int PencilTracker::GetLayout(irr::core::vector3df*& p_startPoints, irr::core::vector3df*& p_endPoints)
+	{
+		int amount = static_cast<int>(m_layoutStarts.size());
+		if (amount > 0)
+		{
+			p_startPoints = new irr::core::vector3df[amount];
+			p_endPoints = new irr::core::vector3df[amount];
+			std::copy(m_layoutStarts.begin(), m_layoutStarts.end(), p_startPoints);
+			std::copy(m_layoutEnds.begin(), m_layoutEnds.end(), p_endPoints);
+		}
+		return amount;
+	}
+
+	void PencilTracker::Reset()
+	{
+		m_tracks.clear();
+		m_layoutStarts.clear();
+		m_layoutEnds.clear();
+		m_sequence = 0;
+		m_hasSequence = false;
+		m_frames = 0;
+		m_layouts = 0;
+	}
+
+	void PencilTracker::SetMatchRatio(float p_ratio)
+	{
+		m_matchRatio = p_ratio;
+	}
+
+	void PencilTracker::SetChangeRatio(float p_ratio)
+	{
+		m_changeRatio = p_ratio;
+	}
+
+	unsigned long PencilTracker::GetFrameCount()
+	{
+		return m_frames;
+	}
+
+	unsigned long PencilTracker::GetLayoutCount()
+	{
+		return m_layouts;
+	}
+
+	float PencilTracker::Distance(const irr::core::vector3df& p_start, const irr::core::vector3df& p_end,
+			const irr::core::vector3df& p_otherStart, const irr::core::vector3df& p_otherEnd, bool& p_swapped)
+	{
+		float length = p_start.getDistanceFrom(p_end);
+		float straight = (p_start.getDistanceFrom(p_otherStart) + p_end.getDistanceFrom(p_otherEnd));
+		float swapped = (p_start.getDistanceFrom(p_otherEnd) + p_end.getDistanceFrom(p_otherStart));
+		p_swapped = (swapped < straight);
+
+		float distance = std::min(straight, swapped);
+		if (length <= 0.0f)
+		{
+			// A pencil without length is only the same as another one without length in the same spot
+			return ((distance <= 0.0f) ? 0.0f : 1e30f);
+		}
+		return (distance / length);
+	}
+
+	int PencilTracker::CountVotes(unsigned int p_votes)
+	{
+		int count = 0;
+		for (; p_votes != 0; p_votes &= (p_votes - 1))
+		{
+			++count;
+		}
+		return count;
+	}
+
+	bool PencilTracker::HasChanged(const std::vector<irr::core::vector3df>& p_starts, const std::vector<irr::core::vector3df>& p_ends)
+	{
+		if (m_layouts == 0)
+		{
+			// Nothing was handed out yet, an empty table is not a layout
+			return !p_starts.empty();
+		}
+		if (p_starts.size() != m_layoutStarts.size())
+		{
+			return true;
+		}
+
+		// Every pencil has to be near its own pencil in the last layout
+		std::vector<bool> used(m_layoutStarts.size(), false);
+		for (size_t i = 0; i < p_starts.size(); ++i)
+		{
+			bool found = false;
+			for (size_t j = 0; !found && j < m_layoutStarts.size(); ++j)
+			{
+				bool swapped = false;
+				if (!used[j] && Distance(m_layoutStarts[j], m_layoutEnds[j], p_starts[i], p_ends[i], swapped) < m_changeRatio)
+				{
+					used[j] = true;
+					found = true;
+				}
+			}
+			if (!found)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+}
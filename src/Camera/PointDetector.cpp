@@ -2,90 +2,115 @@
 
 namespace Camera
 {
-	PointDetector::PointDetector(void)
+	PointDetector::PointDetector(CalibrationParams* p_params)
 	{
+		m_params = p_params;
+		m_undistortPoints = false;
+		m_debugOutput = true;
+		m_workspace = new DetectionWorkspace();
+		m_rejectedBlobs = 0;
+
+		// corners of the destination image, the size follows the board once it is seen
+		m_quadSize = cv::Size(C_QUAD_SIZE, C_QUAD_SIZE);
+		m_quadPoints.resize(4);
+		m_croppedRectification = true;
+		m_cornerEpsilon = 0.5f;
+		m_rectifiedUndistorted = false;
+		m_rectifiedCropped = false;
+		m_reusedRectifications = 0;
+		m_incremental = true;
+		m_checkIncremental = false;
+		m_hasBinary = false;
+		m_tileColumns = 0;
+		m_incrementalScans = 0;
+		m_incrementalMismatches = 0;
+		m_histogram = Utility::Profiler::GetInstance()->GetHistogram("pointdetector.find");
 	}
 
 	PointDetector::~PointDetector(void)
 	{
+		delete m_workspace;
 	}
 
 	int PointDetector::FindPointsInFrame(cv::Mat p_frame, std::vector<cv::Point2f> p_corners, 
 			irr::core::matrix4 p_cameraMatrix, float p_pixelDistance, cv::Size p_sizeHalfed, 
 			irr::core::vector3df*& p_startPoints, irr::core::vector3df*& p_endPoints)
 	{
+		Utility::ProfileScope scope(m_histogram);
+		m_frameSize = p_frame.size();
 		p_cameraMatrix.makeInverse();
 		float startX = (p_pixelDistance / p_sizeHalfed.width);
 		float startZ = (p_pixelDistance / p_sizeHalfed.height);
 
-		cv::Mat quad = cv::Mat::zeros(300, 300, CV_8U);
+		m_workspace->Begin();
+		// The transformations only change when the board moved
+		UpdateRectification(p_corners);
+		cv::Mat quad = m_workspace->GetImage(DetectionWorkspace::BUFFER_CONVERTED, m_quadSize, p_frame.type());
+		// Matches the sizes below to the quad, they were picked for a quad of C_QUAD_SIZE
+		float quadScale = (static_cast<float>(m_quadSize.width) / C_QUAD_SIZE);
 
-		// corners of the destination image
-		std::vector<cv::Point2f> quad_pts;
-		quad_pts.push_back(cv::Point2f(0, 0));
-		quad_pts.push_back(cv::Point2f(quad.cols, 0));
-		quad_pts.push_back(cv::Point2f(quad.cols, quad.rows));
-		quad_pts.push_back(cv::Point2f(0, quad.rows));
-
-		// get transformation matrix
-		cv::Mat matrix = cv::getPerspectiveTransform(p_corners, quad_pts);
-
-		// Apply perspective transformation
-		cv::warpPerspective(p_frame, quad, matrix, quad.size());
+		// Apply perspective transformation, only the part of the frame with the board in it is handed over
+		cv::warpPerspective(p_frame(m_region), quad, m_warpMatrix, quad.size());
 		/*cv::imshow("quadrilateral", quad);
 		cv::waitKey(1);*/
 
-		cv::Mat bw;
-		cv::cvtColor(quad, bw, CV_BGR2GRAY);
-		/*cv::imshow("bw", bw);
-		cv::waitKey(1);*/
-
-		cv::blur(bw, bw, cv::Size(3, 3));
-		/*cv::imshow("bw+blur", bw);
-		cv::waitKey(1);*/
-
-		cv::threshold(bw, bw, 190, 255, cv::THRESH_BINARY);
-		/*cv::imshow("bw+blur+treshold", bw);
-		cv::waitKey(1);*/
-
-		/*cv::Canny( bw, bw, 100, 200, 3 );
-		cv::imshow("bw+blur+treshold+canny", bw);
+		// The grey image has a size of its own, so the blur of a tile sees the same border as the blur of the whole image
+		cv::cvtColor(quad, m_gray, CV_BGR2GRAY);
+		/*cv::imshow("bw", m_gray);
 		cv::waitKey(1);*/
 
 		// Find contours in the black & white image.
-		std::vector<std::vector<cv::Point>> contours;
-		cv::findContours(bw, contours, CV_RETR_LIST, CV_CHAIN_APPROX_SIMPLE, cv::Point(10, 10));
-
-		int contoursSize = 0;
-		std::vector<std::vector<cv::Point>> pointContours;
-
-		// Determine if we can skip certain contours.
-		for (int i = 0; i < contours.size(); i++)
+		cv::Point contourOffset = cv::Point(10, 10);
+		bool incremental = (m_incremental && m_hasBinary && m_binary.size() == m_gray.size());
+		if (!incremental)
 		{
-			double areaSize = std::fabs(cv::contourArea(contours[i]));
+			cv::Mat blurred = m_workspace->GetImage(DetectionWorkspace::BUFFER_FILTERED, m_quadSize, CV_8UC1);
+			cv::blur(m_gray, blurred, cv::Size(3, 3));
+			cv::threshold(blurred, m_binary, 190, 255, cv::THRESH_BINARY);
+			/*cv::imshow("bw+blur+treshold", m_binary);
+			cv::waitKey(1);*/
+
+			m_blobs.clear();
+			ScanRegion(cv::Rect(0, 0, m_binary.cols, m_binary.rows), quadScale, contourOffset, m_blobs);
+			std::sort(m_blobs.begin(), m_blobs.end(), CompareBlobs);
+			m_hasBinary = true;
+		}
+		else if (ThresholdChangedTiles())
+		{
+			// Only the blobs around the tiles that changed are found again, the rest is kept
+			UpdateBlobs(quadScale, contourOffset);
+			++m_incrementalScans;
 
-			// The pencils / markers have an area size around 200-500px.
-			// Skip contours with an area smaller than 100px to avoid noise and contours with an area larger than 1000px to skip large objects.
-			if (areaSize < 100 || areaSize > 1000)
+			if (m_checkIncremental)
 			{
-				continue;
+				std::vector<Blob> full;
+				ScanRegion(cv::Rect(0, 0, m_binary.cols, m_binary.rows), quadScale, contourOffset, full);
+				std::sort(full.begin(), full.end(), CompareBlobs);
+				if (!IsSamePencils(full, m_blobs))
+				{
+					++m_incrementalMismatches;
+					Utility::Logger::GetInstance()->Log(Utility::Logger::LOG_ERROR, "PointDetector: The incremental search differs from a full search");
+				}
 			}
+		}
+		cv::swap(m_gray, m_lastGray);
 
-			cv::Mat curve = cv::Mat(contours[i]);
-			std::vector<cv::Point2f> approx;
-			curve.convertTo(curve, cv::Mat(approx).type());
-			cv::approxPolyDP(curve, approx, (cv::arcLength(curve, true) * 0.02), true);
-
-			if (approx.size() < 4)
+		// The blobs are kept in the order of the image, whatever part of it was searched
+		m_pencilStarts.clear();
+		m_pencilEnds.clear();
+		for (size_t i = 0; i < m_blobs.size(); i++)
+		{
+			const Blob& blob = m_blobs[i];
+			if (!blob.m_pencil)
 			{
 				continue;
 			}
 
-			contoursSize++;
-			pointContours.push_back(contours[i]);
+			m_pencilStarts.push_back(blob.m_pointA);
+			m_pencilEnds.push_back(blob.m_pointB);
 		}
 
-
+		int contoursSize = static_cast<int>(m_pencilStarts.size());
 		if (contoursSize > 0)
 		{
 			p_startPoints = new irr::core::vector3df[contoursSize];
@@ -93,101 +118,510 @@ namespace Camera
 
 			for (int i = 0; i < contoursSize; i++)
 			{
-				cv::Mat curve = cv::Mat(pointContours[i]);
-				std::vector<cv::Point2f> approx;
-				// Convert from std::vector<cv::Point> to Corners
-				curve.convertTo(curve, cv::Mat(approx).type());
+				// It does not matter if A or B is the top or lower point.
+				cv::Point2f pointA = m_pencilStarts[i];
+				cv::Point2f pointB = m_pencilEnds[i];
 
-				cv::approxPolyDP(curve, approx, (cv::arcLength(curve, true) * 0.02), true);
+				if (!m_undistortedMatrix.empty())
+				{
+					std::vector<cv::Point2f> points;
+					points.push_back(pointA - cv::Point2f(contourOffset));
+					points.push_back(pointB - cv::Point2f(contourOffset));
+					UndistortQuadPoints(points, m_inverseMatrix, m_undistortedMatrix);
+					pointA = points.at(0) + cv::Point2f(contourOffset);
+					pointB = points.at(1) + cv::Point2f(contourOffset);
+				}
+
+				// Back to a quad of C_QUAD_SIZE, which is what the game coordinates are measured in
+				pointA = (((pointA - cv::Point2f(contourOffset)) * (1.0f / quadScale)) + cv::Point2f(contourOffset));
+				pointB = (((pointB - cv::Point2f(contourOffset)) * (1.0f / quadScale)) + cv::Point2f(contourOffset));
+
+				irr::core::vector3df pointTop;
+				irr::core::vector3df pointBottom;
 
-				// Only use approx when it has at least 4 points.
-				if (approx.size() >= 4)
+				// Determine which point is top or bottom.
+				if (pointA.y > pointB.y)
+				{
+					pointTop.X = pointA.x * startX;
+					pointTop.Y = pointA.y * startZ;
+					pointTop.Z = 0.0f;
+
+					pointBottom.X = pointB.x * startX;
+					pointBottom.Y = pointB.y * startZ;
+					pointBottom.Z = 0.0f;
+				}
+				else
 				{
-					std::cout << i << ") " << approx.size() << std::endl; // Debug how many approxes are in the contour.
+					pointTop.X = pointB.x * startX;
+					pointTop.Y = pointB.y * startZ;
+					pointTop.Z = 0.0f;
 
-					// Define 2 points for begin and end, it does not matter if A or B is the top or lower point.
-					cv::Point2f pointA, pointB;
+					pointBottom.X = pointA.x * startX;
+					pointBottom.Y = pointA.y * startZ;
+					pointBottom.Z = 0.0f;
+				}
 
-					// Define a skip length. If points are in this range only one of the points will be used.
-					int pointSkipLength = 15;
+				p_cameraMatrix.transformVect(pointTop);
+				p_cameraMatrix.transformVect(pointBottom);
 
-					// Loop through all of the points in the contour
-					for (int j = 0; j < approx.size(); j++)
-					{
-						cv::circle(quad, cv::Point(approx.at(j).x, approx.at(j).y), 3, cv::Scalar(255, 0, 0)); // DUMMY visualizer for all points in the contour.
+				p_startPoints[i] = irr::core::vector3df(pointTop.Y, pointTop.Z, pointTop.X);
+				p_endPoints[i] = irr::core::vector3df(pointBottom.Y, pointBottom.Z, pointBottom.X);
+			}
+		}
 
-						// Only set point A If it is not set yet.
-						if (pointA.x == 0 && pointA.y == 0)
-						{
-							pointA.x = approx.at(j).x;
-							pointA.y = approx.at(j).y;
+		if (m_debugOutput && DebugOverlay::GetInstance()->IsEnabled())
+		{
+			ShowPencils(contourOffset);
+		}
 
-							cv::circle(quad, pointA, 4, cv::Scalar(0, 0, 255)); // DUMMY visualizer for point A.
-						}
-						else
+		m_workspace->End();
+		return contoursSize;
+	}
+
+	unsigned long PointDetector::GetReallocationCount()
+	{
+		return m_workspace->GetReallocationCount();
+	}
+
+	unsigned long PointDetector::GetRejectedCount()
+	{
+		return m_rejectedBlobs;
+	}
+
+	unsigned long PointDetector::GetReusedRectificationCount()
+	{
+		return m_reusedRectifications;
+	}
+
+	void PointDetector::SetCroppedRectification(bool p_croppedRectification)
+	{
+		m_croppedRectification = p_croppedRectification;
+	}
+
+	void PointDetector::SetIncremental(bool p_incremental)
+	{
+		m_incremental = p_incremental;
+	}
+
+	void PointDetector::SetCheckIncremental(bool p_checkIncremental)
+	{
+		m_checkIncremental = p_checkIncremental;
+	}
+
+	unsigned long PointDetector::GetIncrementalCount()
+	{
+		return m_incrementalScans;
+	}
+
+	unsigned long PointDetector::GetIncrementalMismatchCount()
+	{
+		return m_incrementalMismatches;
+	}
+
+	void PointDetector::SetUndistortPoints(bool p_undistortPoints)
+	{
+		m_undistortPoints = p_undistortPoints;
+	}
+
+	void PointDetector::SetDebugOutput(bool p_debugOutput)
+	{
+		m_debugOutput = p_debugOutput;
+	}
+
+	void PointDetector::UpdateRectification(const std::vector<cv::Point2f>& p_corners)
+	{
+		bool undistort = (m_undistortPoints && m_params != NULL && m_params->GetIsOpenedAndGood());
+		bool changed = (m_rectifiedCorners.size() != p_corners.size() || m_rectifiedFrameSize != m_frameSize
+				|| m_rectifiedUndistorted != undistort || m_rectifiedCropped != m_croppedRectification);
+		for (size_t i = 0; !changed && i < p_corners.size(); ++i)
+		{
+			cv::Point2f difference = (p_corners[i] - m_rectifiedCorners[i]);
+			changed = (std::fabs(difference.x) > m_cornerEpsilon || std::fabs(difference.y) > m_cornerEpsilon);
+		}
+		if (!changed)
+		{
+			++m_reusedRectifications;
+			return;
+		}
+
+		m_rectifiedCorners = p_corners;
+		m_rectifiedFrameSize = m_frameSize;
+		m_rectifiedUndistorted = undistort;
+		m_rectifiedCropped = m_croppedRectification;
+
+		cv::Rect frame = cv::Rect(0, 0, m_frameSize.width, m_frameSize.height);
+		int side = C_QUAD_SIZE;
+		m_region = frame;
+		if (m_croppedRectification)
+		{
+			// One pixel around the board, the interpolation looks at the neighbours of the corners
+			cv::Rect box = cv::boundingRect(p_corners);
+			m_region = (cv::Rect((box.x - 1), (box.y - 1), (box.width + 2), (box.height + 2)) & frame);
+			if (m_region.area() == 0)
+			{
+				m_region = frame;
+			}
+
+			// About as many pixels as the board has on screen, more would only be interpolated
+			side = static_cast<int>(std::sqrt(std::fabs(cv::contourArea(p_corners))));
+			side = (((side + (C_QUAD_STEP / 2)) / C_QUAD_STEP) * C_QUAD_STEP);
+			side = std::max(C_MIN_QUAD_SIZE, std::min(C_QUAD_SIZE, side));
+		}
+
+		m_quadSize = cv::Size(side, side);
+		m_quadPoints[0] = cv::Point2f(0, 0);
+		m_quadPoints[1] = cv::Point2f(static_cast<float>(side), 0);
+		m_quadPoints[2] = cv::Point2f(static_cast<float>(side), static_cast<float>(side));
+		m_quadPoints[3] = cv::Point2f(0, static_cast<float>(side));
+
+		// get transformation matrix, the warp starts at the top left of the region instead of the frame
+		cv::Mat matrix = cv::getPerspectiveTransform(p_corners, m_quadPoints);
+		m_quadToFrame = matrix.inv();
+		cv::Mat shift = (cv::Mat_<double>(3, 3) <<
+				1.0, 0.0, m_region.x,
+				0.0, 1.0, m_region.y,
+				0.0, 0.0, 1.0);
+		m_warpMatrix = (matrix * shift);
+
+		// When the frame is distorted only the points that are found get undistorted
+		m_inverseMatrix.release();
+		m_undistortedMatrix.release();
+		if (undistort)
+		{
+			std::vector<cv::Point2f> undistortedCorners = p_corners;
+			m_params->UndistortPoints(undistortedCorners, m_frameSize);
+			m_inverseMatrix = m_quadToFrame;
+			m_undistortedMatrix = cv::getPerspectiveTransform(undistortedCorners, m_quadPoints);
+		}
+	}
+
+	bool PointDetector::ThresholdChangedTiles()
+	{
+		cv::Rect image = cv::Rect(0, 0, m_binary.cols, m_binary.rows);
+		int columns = (((image.width + C_TILE_SIZE) - 1) / C_TILE_SIZE);
+		int rows = (((image.height + C_TILE_SIZE) - 1) / C_TILE_SIZE);
+		m_tileColumns = columns;
+		m_dirtyTiles.assign((columns * rows), 0);
+
+		bool changed = false;
+		for (int tileY = 0; tileY < rows; ++tileY)
+		{
+			for (int tileX = 0; tileX < columns; ++tileX)
+			{
+				cv::Rect tile = (cv::Rect((tileX * C_TILE_SIZE), (tileY * C_TILE_SIZE), C_TILE_SIZE, C_TILE_SIZE) & image);
+				if (IsSame(m_gray(tile), m_lastGray(tile)))
+				{
+					continue;
+				}
+
+				// The blur reaches one pixel into the tiles around it
+				cv::Rect area = (cv::Rect((tile.x - 1), (tile.y - 1), (tile.width + 2), (tile.height + 2)) & image);
+				cv::Mat binary = m_workspace->GetImage(DetectionWorkspace::BUFFER_FILTERED, area.size(), CV_8UC1);
+				cv::blur(m_gray(area), binary, cv::Size(3, 3));
+				cv::threshold(binary, binary, 190, 255, cv::THRESH_BINARY);
+
+				// Only tiles of which the black & white image changed have to be searched again
+				for (int y = (area.y / C_TILE_SIZE); y <= ((area.br().y - 1) / C_TILE_SIZE); ++y)
+				{
+					for (int x = (area.x / C_TILE_SIZE); x <= ((area.br().x - 1) / C_TILE_SIZE); ++x)
+					{
+						cv::Rect part = (cv::Rect((x * C_TILE_SIZE), (y * C_TILE_SIZE), C_TILE_SIZE, C_TILE_SIZE) & area);
+						if (!IsSame(binary(part - area.tl()), m_binary(part)))
 						{
-							// If points are within the range we can skip this point.
-							if (abs(pointA.x - approx.at(j).x) < pointSkipLength && abs(pointA.y - approx.at(j).y) < pointSkipLength)
-							{
-								continue;
-							}
-							else
-							{
-								// Only set point B if it is not set, yet.
-								if (pointB.x == 0 && pointB.y == 0)
-								{
-									pointB.x = approx.at(j).x;
-									pointB.y = approx.at(j).y;
-
-									cv::circle(quad, pointB, 4, cv::Scalar(0, 0, 255)); // DUMMY visualizer for point B.
-
-									// We got point A and B, no need to look further.
-									break;
-								}
-							}
+							m_dirtyTiles[(y * columns) + x] = 1;
+							changed = true;
 						}
 					}
+				}
+				binary.copyTo(m_binary(area));
+			}
+		}
+		return changed;
+	}
 
-					irr::core::vector3df pointTop;
-					irr::core::vector3df pointBottom;
+	void PointDetector::UpdateBlobs(float p_scale, cv::Point p_offset)
+	{
+		cv::Rect image = cv::Rect(0, 0, m_binary.cols, m_binary.rows);
 
-					// Determine which point is top or bottom.
-					if (pointA.y > pointB.y)
-					{
-						pointTop.X = pointA.x * startX;
-						pointTop.Y = pointA.y * startZ;
-						pointTop.Z = 0.0f;
+		// The tiles that changed and the tiles around them
+		cv::Rect region;
+		for (size_t i = 0; i < m_dirtyTiles.size(); ++i)
+		{
+			if (m_dirtyTiles[i] != 0)
+			{
+				int x = (static_cast<int>(i % m_tileColumns) * C_TILE_SIZE);
+				int y = (static_cast<int>(i / m_tileColumns) * C_TILE_SIZE);
+				cv::Rect neighbours = cv::Rect((x - C_TILE_SIZE), (y - C_TILE_SIZE), (C_TILE_SIZE * 3), (C_TILE_SIZE * 3));
+				region = ((region.area() == 0) ? neighbours : (region | neighbours));
+			}
+		}
+		region &= image;
 
-						pointBottom.X = pointB.x * startX;
-						pointBottom.Y = pointB.y * startZ;
-						pointBottom.Z = 0.0f;
-					}
-					else
+		// Grows the region until every blob that is in it was found as a whole
+		m_scannedBlobs.clear();
+		bool complete = false;
+		while (!complete)
+		{
+			// A blob that was partly in the region may have changed as a whole
+			bool grown = true;
+			while (grown)
+			{
+				grown = false;
+				for (size_t i = 0; i < m_blobs.size(); ++i)
+				{
+					cv::Rect overlap = (m_blobs[i].m_bounds & region);
+					if (overlap.area() > 0 && overlap != m_blobs[i].m_bounds)
 					{
-						pointTop.X = pointB.x * startX;
-						pointTop.Y = pointB.y * startZ;
-						pointTop.Z = 0.0f;
-
-						pointBottom.X = pointA.x * startX;
-						pointBottom.Y = pointA.y * startZ;
-						pointBottom.Z = 0.0f;
+						region |= m_blobs[i].m_bounds;
+						grown = true;
 					}
+				}
+			}
 
-					p_cameraMatrix.transformVect(pointTop);
-					p_cameraMatrix.transformVect(pointBottom);
+			m_scannedBlobs.clear();
+			cv::Rect grow = ScanRegion(region, p_scale, p_offset, m_scannedBlobs);
+			complete = (grow == region);
+			region = grow;
+		}
+
+		// The blobs in the region were all found again
+		size_t kept = 0;
+		for (size_t i = 0; i < m_blobs.size(); ++i)
+		{
+			if ((m_blobs[i].m_bounds & region).area() == 0)
+			{
+				m_blobs[kept++] = m_blobs[i];
+			}
+		}
+		m_blobs.resize(kept);
+		m_blobs.insert(m_blobs.end(), m_scannedBlobs.begin(), m_scannedBlobs.end());
+		std::sort(m_blobs.begin(), m_blobs.end(), CompareBlobs);
+	}
 
-					p_startPoints[i] = irr::core::vector3df(pointTop.Y, pointTop.Z, pointTop.X);
-					p_endPoints[i] = irr::core::vector3df(pointBottom.Y, pointBottom.Z, pointBottom.X);
+	cv::Rect PointDetector::ScanRegion(cv::Rect p_region, float p_scale, cv::Point p_offset, std::vector<Blob>& p_blobs)
+	{
+		cv::Rect image = cv::Rect(0, 0, m_binary.cols, m_binary.rows);
+
+		// A border of zeroes around the region. The search clears the outer pixels of the whole image,
+		// so those are cleared here too where the region reaches the edge of the image.
+		cv::Mat scan = m_workspace->GetImage(DetectionWorkspace::BUFFER_EDGES, cv::Size((p_region.width + 2), (p_region.height + 2)), CV_8UC1);
+		scan.setTo(cv::Scalar(0));
+		m_binary(p_region).copyTo(scan(cv::Rect(1, 1, p_region.width, p_region.height)));
+		if (p_region.x == 0)
+		{
+			scan.col(1).setTo(cv::Scalar(0));
+		}
+		if (p_region.y == 0)
+		{
+			scan.row(1).setTo(cv::Scalar(0));
+		}
+		if (p_region.br().x == image.width)
+		{
+			scan.col(p_region.width).setTo(cv::Scalar(0));
+		}
+		if (p_region.br().y == image.height)
+		{
+			scan.row(p_region.height).setTo(cv::Scalar(0));
+		}
 
-					// Draw a bounding box around the contour.
-					cv::Rect boundingBox = cv::boundingRect(approx);
-					cv::rectangle(quad, boundingBox, cv::Scalar(0, 255, 0));
-				}
+		// The points come out in the same coordinates as when the whole image is searched
+		int contourCount = m_workspace->FindContours(scan, (p_offset + p_region.tl() - cv::Point(1, 1)));
 
-				cv::imshow("bw boundingbox", quad);
+		// A blob against the side of the region may go on outside of it, the region then grows a tile that way
+		cv::Rect grown = p_region;
+		for (int i = 0; i < contourCount; i++)
+		{
+			cv::Mat contour = m_workspace->GetContour(i);
+			if (contour.empty())
+			{
+				continue;
+			}
+
+			cv::Rect bounds = (cv::boundingRect(contour) - p_offset);
+			if (bounds.x == p_region.x && p_region.x > 0)
+			{
+				grown |= cv::Rect((p_region.x - C_TILE_SIZE), p_region.y, C_TILE_SIZE, p_region.height);
+			}
+			if (bounds.y == p_region.y && p_region.y > 0)
+			{
+				grown |= cv::Rect(p_region.x, (p_region.y - C_TILE_SIZE), p_region.width, C_TILE_SIZE);
+			}
+			if (bounds.br().x == p_region.br().x && p_region.br().x < image.width)
+			{
+				grown |= cv::Rect(p_region.br().x, p_region.y, C_TILE_SIZE, p_region.height);
+			}
+			if (bounds.br().y == p_region.br().y && p_region.br().y < image.height)
+			{
+				grown |= cv::Rect(p_region.x, p_region.br().y, p_region.width, C_TILE_SIZE);
 			}
 		}
+		grown &= image;
+		if (grown != p_region)
+		{
+			return grown;
+		}
 
-		return contoursSize;
+		// One pass over the contours: filter on size and shape and find the ends of what is left
+		for (int i = 0; i < contourCount; i++)
+		{
+			cv::Mat contour = m_workspace->GetContour(i);
+			if (contour.empty())
+			{
+				continue;
+			}
+
+			Blob blob;
+			blob.m_bounds = (cv::boundingRect(contour) - p_offset);
+			blob.m_first = contour.at<cv::Point>(0);
+			blob.m_pencil = FindEnds(contour, p_scale, blob.m_pointA, blob.m_pointB);
+			p_blobs.push_back(blob);
+		}
+		return p_region;
+	}
+
+	bool PointDetector::IsSame(const cv::Mat& p_first, const cv::Mat& p_second)
+	{
+		size_t rowSize = (p_first.cols * p_first.elemSize());
+		for (int row = 0; row < p_first.rows; ++row)
+		{
+			if (memcmp(p_first.ptr(row), p_second.ptr(row), rowSize) != 0)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool PointDetector::IsSamePencils(const std::vector<Blob>& p_first, const std::vector<Blob>& p_second)
+	{
+		if (p_first.size() != p_second.size())
+		{
+			return false;
+		}
+		for (size_t i = 0; i < p_first.size(); ++i)
+		{
+			const Blob& first = p_first[i];
+			const Blob& second = p_second[i];
+			if (first.m_bounds != second.m_bounds || first.m_first != second.m_first || first.m_pencil != second.m_pencil
+					|| (first.m_pencil && (first.m_pointA != second.m_pointA || first.m_pointB != second.m_pointB)))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool PointDetector::CompareBlobs(const Blob& p_first, const Blob& p_second)
+	{
+		if (p_first.m_first.y != p_second.m_first.y)
+		{
+			return (p_first.m_first.y < p_second.m_first.y);
+		}
+		if (p_first.m_first.x != p_second.m_first.x)
+		{
+			return (p_first.m_first.x < p_second.m_first.x);
+		}
+		// An outer contour and the hole in it may start at the same point, the outer one is larger
+		return (p_first.m_bounds.area() > p_second.m_bounds.area());
+	}
+
+	void PointDetector::ShowPencils(cv::Point p_offset)
+	{
+		// Everything is shown in the frame, the quad itself is never shown
+		std::vector<cv::Point2f> points;
+		for (size_t i = 0; i < m_blobs.size(); ++i)
+		{
+			const Blob& blob = m_blobs[i];
+			if (blob.m_pencil)
+			{
+				cv::Point2f offset = cv::Point2f(p_offset);
+				points.push_back(blob.m_pointA - offset);
+				points.push_back(blob.m_pointB - offset);
+				points.push_back(cv::Point2f(static_cast<float>(blob.m_bounds.x), static_cast<float>(blob.m_bounds.y)));
+				points.push_back(cv::Point2f(static_cast<float>(blob.m_bounds.br().x), static_cast<float>(blob.m_bounds.y)));
+				points.push_back(cv::Point2f(static_cast<float>(blob.m_bounds.br().x), static_cast<float>(blob.m_bounds.br().y)));
+				points.push_back(cv::Point2f(static_cast<float>(blob.m_bounds.x), static_cast<float>(blob.m_bounds.br().y)));
+			}
+		}
+		std::vector<cv::Point2f> framePoints;
+		if (!points.empty())
+		{
+			cv::perspectiveTransform(points, framePoints, m_quadToFrame);
+		}
+
+		DebugOverlay* overlay = DebugOverlay::GetInstance();
+		overlay->Clear(DebugOverlay::SOURCE_PENCILS);
+		for (size_t i = 0; (i + 5) < framePoints.size(); i += 6)
+		{
+			overlay->AddPoint(DebugOverlay::SOURCE_PENCILS, framePoints[i], m_frameSize, cv::Scalar(0, 0, 255));
+			overlay->AddPoint(DebugOverlay::SOURCE_PENCILS, framePoints[i + 1], m_frameSize, cv::Scalar(0, 0, 255));
+			// The bounding box of the blob in the quad, which is skewed in the frame
+			for (size_t corner = 0; corner < 4; ++corner)
+			{
+				overlay->AddLine(DebugOverlay::SOURCE_PENCILS, framePoints[i + 2 + corner], framePoints[i + 2 + ((corner + 1) % 4)], m_frameSize, cv::Scalar(0, 255, 0));
+			}
+		}
+
+		std::ostringstream label;
+		label << m_pencilStarts.size() << " pencils, " << m_rejectedBlobs << " blobs rejected so far";
+		overlay->AddLabel(DebugOverlay::SOURCE_PENCILS, label.str(), cv::Point2f(10.0f, 20.0f), m_frameSize, cv::Scalar(0, 255, 0));
+	}
+
+	bool PointDetector::FindEnds(const cv::Mat& p_contour, float p_scale, cv::Point2f& p_pointA, cv::Point2f& p_pointB)
+	{
+		// The pencils / markers have an area size around 200-500px.
+		// Skip contours with an area smaller than 100px to avoid noise and contours with an area larger than 1000px to skip large objects.
+		cv::Moments moments = cv::moments(p_contour);
+		double area = (std::fabs(moments.m00) / (p_scale * p_scale));
+		if (area < C_MIN_AREA || area > C_MAX_AREA)
+		{
+			return false;
+		}
+
+		// The axis of the blob is the eigenvector of its second-order central moments with the largest eigenvalue
+		double spread = std::sqrt((4.0 * moments.mu11 * moments.mu11) + ((moments.mu20 - moments.mu02) * (moments.mu20 - moments.mu02)));
+		double major = ((moments.mu20 + moments.mu02) + spread);
+		double minor = ((moments.mu20 + moments.mu02) - spread);
+		if (major <= 0.0 || (minor > 0.0 && (major / minor) < (C_MIN_ELONGATION * C_MIN_ELONGATION)))
+		{
+			// Round blobs have no direction to follow
+			++m_rejectedBlobs;
+			return false;
+		}
+
+		double angle = (0.5 * std::atan2((2.0 * moments.mu11), (moments.mu20 - moments.mu02)));
+		cv::Point2f axis = cv::Point2f(static_cast<float>(std::cos(angle)), static_cast<float>(std::sin(angle)));
+		cv::Point2f center = cv::Point2f(static_cast<float>(moments.m10 / moments.m00), static_cast<float>(moments.m01 / moments.m00));
+
+		// The ends are the points of the contour that stick out furthest along the axis
+		float lowest = 0.0f;
+		float highest = 0.0f;
+		const cv::Point* points = p_contour.ptr<cv::Point>(0);
+		for (int i = 0; i < p_contour.rows; ++i)
+		{
+			cv::Point2f offset = (cv::Point2f(static_cast<float>(points[i].x), static_cast<float>(points[i].y)) - center);
+			float position = offset.dot(axis);
+			lowest = std::min(lowest, position);
+			highest = std::max(highest, position);
+		}
+
+		if ((highest - lowest) < (C_MIN_LENGTH * p_scale))
+		{
+			++m_rejectedBlobs;
+			return false;
+		}
+
+		p_pointA = (center + (axis * lowest));
+		p_pointB = (center + (axis * highest));
+		return true;
+	}
+
+	void PointDetector::UndistortQuadPoints(std::vector<cv::Point2f>& p_points,
+			cv::Mat p_inverseMatrix, cv::Mat p_undistortedMatrix)
+	{
+		std::vector<cv::Point2f> framePoints;
+		cv::perspectiveTransform(p_points, framePoints, p_inverseMatrix);
+		m_params->UndistortPoints(framePoints, m_frameSize);
+		cv::perspectiveTransform(framePoints, p_points, p_undistortedMatrix);
 	}
 }
\ No newline at end of file
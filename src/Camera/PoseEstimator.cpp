@@ -0,0 +1,113 @@
+#include "Camera/PoseEstimator.h"
+
+namespace Camera
+{
+	PoseEstimator::PoseEstimator(CalibrationParams* p_params)
+	{
+		m_params = p_params;
+		m_objectPoints.resize(4);
+		m_projectedPoints.resize(4);
+		m_distortion = cv::Mat::zeros(1, 5, CV_64F);
+		m_rotationVector = cv::Mat::zeros(3, 1, CV_64F);
+		m_translationVector = cv::Mat::zeros(3, 1, CV_64F);
+		m_hasPose = false;
+		m_maxError = 4.0f;
+		m_lastError = 0.0f;
+	}
+
+	PoseEstimator::~PoseEstimator()
+	{
+	}
+
+	bool PoseEstimator::Estimate(const std::vector<cv::Point2f>& p_corners, float p_height, float p_length, irr::core::matrix4& p_pose)
+	{
+		if (p_corners.size() != 4 || p_height <= 0.0f || p_length <= 0.0f)
+		{
+			return false;
+		}
+
+		// The corners are undistorted before they get here, so only the camera matrix is needed
+		if (m_frameSize.area() == 0)
+		{
+			m_cameraMatrix = m_params->GetCameraMatrix();
+		}
+		else if (m_cameraMatrix.empty())
+		{
+			// Only scaled again when the frame size changes
+			m_cameraMatrix = m_params->GetCameraMatrix(m_frameSize);
+		}
+
+		// Top left, top right, bottom right and bottom left; the same order as the sorted corners
+		m_objectPoints[0] = cv::Point3f(0.0f, 0.0f, 0.0f);
+		m_objectPoints[1] = cv::Point3f(0.0f, 0.0f, -p_height);
+		m_objectPoints[2] = cv::Point3f(-p_length, 0.0f, -p_height);
+		m_objectPoints[3] = cv::Point3f(-p_length, 0.0f, 0.0f);
+
+		// IPPE is not available in this OpenCV version; the iterative solver initialises
+		// a planar target from its homography and refines from the previous pose when there is one
+		bool solved = cv::solvePnP(m_objectPoints, p_corners, m_cameraMatrix, m_distortion,
+				m_rotationVector, m_translationVector, m_hasPose, CV_ITERATIVE);
+
+		if (!solved || m_translationVector.at<double>(2) <= 0.0)
+		{
+			Reset();
+			return false;
+		}
+
+		cv::projectPoints(m_objectPoints, m_rotationVector, m_translationVector, m_cameraMatrix, m_distortion, m_projectedPoints);
+		float error = 0.0f;
+		for (int i = 0; i < 4; ++i)
+		{
+			cv::Point2f difference = (m_projectedPoints[i] - p_corners[i]);
+			error += std::sqrt((difference.x * difference.x) + (difference.y * difference.y));
+		}
+		m_lastError = (error / 4.0f);
+
+		if (m_lastError > m_maxError)
+		{
+			// Do not let a bad fit seed the next estimate
+			Reset();
+			return false;
+		}
+		m_hasPose = true;
+
+		// OpenCV looks down +z with +y pointing down, Irrlicht looks down +z with +y pointing up.
+		// Flipping y on both sides of the rotation keeps it a proper rotation and the playground's up pointing up.
+		cv::Rodrigues(m_rotationVector, m_rotation);
+		const float flip[3] = {1.0f, -1.0f, 1.0f};
+		p_pose = irr::core::IdentityMatrix;
+		for (int row = 0; row < 3; ++row)
+		{
+			for (int column = 0; column < 3; ++column)
+			{
+				p_pose[(column * 4) + row] = static_cast<float>(flip[row] * flip[column] * m_rotation.at<double>(row, column));
+			}
+			p_pose[12 + row] = static_cast<float>(flip[row] * m_translationVector.at<double>(row));
+		}
+
+		return true;
+	}
+
+	void PoseEstimator::Reset()
+	{
+		m_hasPose = false;
+		m_rotationVector.setTo(cv::Scalar(0.0));
+		m_translationVector.setTo(cv::Scalar(0.0));
+	}
+
+	void PoseEstimator::SetMaxError(float p_maxError)
+	{
+		m_maxError = p_maxError;
+	}
+
+	void PoseEstimator::SetFrameSize(cv::Size p_size)
+	{
+		m_frameSize = p_size;
+		m_cameraMatrix.release();
+	}
+
+	float PoseEstimator::GetLastError()
+	{
+		return m_lastError;
+	}
+}
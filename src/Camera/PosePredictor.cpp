@@ -0,0 +1,138 @@
+#include "Camera/PosePredictor.h"
+
+namespace Camera
+{
+	PosePredictor::PosePredictor()
+	{
+		m_minCutoff = 1.0;
+		m_derivativeCutoff = 1.0;
+		m_translationBeta = 0.01;
+		m_rotationBeta = 2.0;
+		Reset();
+	}
+
+	PosePredictor::~PosePredictor()
+	{
+	}
+
+	irr::core::matrix4 PosePredictor::Update(const irr::core::matrix4& p_pose, double p_time)
+	{
+		if (!m_hasPose)
+		{
+			m_hasPose = true;
+			m_time = p_time;
+			m_translation = p_pose.getTranslation();
+			m_rotation = GetRotation(p_pose);
+			return GetPose();
+		}
+
+		double interval = (p_time - m_time);
+		if (interval <= 0.0)
+		{
+			// The same frame again, there is nothing to learn from it
+			return GetPose();
+		}
+		m_time = p_time;
+
+		// Translation, the speed is low-passed on its own before it sets the cut-off
+		irr::core::vector3df translation = p_pose.getTranslation();
+		irr::core::vector3df rawVelocity = ((translation - m_translation) / static_cast<float>(interval));
+		m_velocity += ((rawVelocity - m_velocity) * static_cast<float>(GetAlpha(m_derivativeCutoff, interval)));
+		double cutoff = (m_minCutoff + (m_translationBeta * m_velocity.getLength()));
+		m_translation += ((translation - m_translation) * static_cast<float>(GetAlpha(cutoff, interval)));
+
+		// Rotation, the step from the filtered to the measured rotation is scaled instead of the angles
+		cv::Matx33d difference = (GetRotation(p_pose) * m_rotation.t());
+		cv::Vec3d step;
+		cv::Rodrigues(difference, step);
+		cv::Vec3d rawAngularVelocity = (step * (1.0 / interval));
+		m_angularVelocity += ((rawAngularVelocity - m_angularVelocity) * GetAlpha(m_derivativeCutoff, interval));
+		cutoff = (m_minCutoff + (m_rotationBeta * cv::norm(m_angularVelocity)));
+		cv::Matx33d partial;
+		cv::Rodrigues(cv::Vec3d(step * GetAlpha(cutoff, interval)), partial);
+		m_rotation = (partial * m_rotation);
+
+		return GetPose();
+	}
+
+	void PosePredictor::Reset()
+	{
+		m_hasPose = false;
+		m_time = 0.0;
+		m_translation = irr::core::vector3df(0.0f, 0.0f, 0.0f);
+		m_velocity = irr::core::vector3df(0.0f, 0.0f, 0.0f);
+		m_rotation = cv::Matx33d::eye();
+		m_angularVelocity = cv::Vec3d(0.0, 0.0, 0.0);
+	}
+
+	irr::core::matrix4 PosePredictor::GetPose()
+	{
+		irr::core::matrix4 pose = irr::core::IdentityMatrix;
+		SetRotation(pose, m_rotation);
+		pose.setTranslation(m_translation);
+		return pose;
+	}
+
+	irr::core::vector3df PosePredictor::GetVelocity()
+	{
+		return m_velocity;
+	}
+
+	cv::Vec3d PosePredictor::GetAngularVelocity()
+	{
+		return m_angularVelocity;
+	}
+
+	void PosePredictor::SetMinCutoff(double p_minCutoff)
+	{
+		m_minCutoff = p_minCutoff;
+	}
+
+	void PosePredictor::SetBeta(double p_translationBeta, double p_rotationBeta)
+	{
+		m_translationBeta = p_translationBeta;
+		m_rotationBeta = p_rotationBeta;
+	}
+
+	irr::core::matrix4 PosePredictor::Extrapolate(const irr::core::matrix4& p_pose, const irr::core::vector3df& p_velocity, const cv::Vec3d& p_angularVelocity, double p_seconds)
+	{
+		irr::core::matrix4 pose = p_pose;
+		pose.setTranslation(p_pose.getTranslation() + (p_velocity * static_cast<float>(p_seconds)));
+
+		cv::Matx33d step;
+		cv::Rodrigues(cv::Vec3d(p_angularVelocity * p_seconds), step);
+		SetRotation(pose, (step * GetRotation(p_pose)));
+		return pose;
+	}
+
+	double PosePredictor::GetAlpha(double p_cutoff, double p_interval)
+	{
+		double tau = (1.0 / (2.0 * CV_PI * p_cutoff));
+		return (1.0 / (1.0 + (tau / p_interval)));
+	}
+
+	cv::Matx33d PosePredictor::GetRotation(const irr::core::matrix4& p_matrix)
+	{
+		// Irrlicht multiplies row vectors, so its rotation is the transpose of the column vector one
+		cv::Matx33d rotation;
+		for (int row = 0; row < 3; ++row)
+		{
+			for (int column = 0; column < 3; ++column)
+			{
+				rotation(row, column) = p_matrix[(column * 4) + row];
+			}
+		}
+		return rotation;
+	}
+
+	void PosePredictor::SetRotation(irr::core::matrix4& p_matrix, const cv::Matx33d& p_rotation)
+	{
+		for (int row = 0; row < 3; ++row)
+		{
+			for (int column = 0; column < 3; ++column)
+			{
+				p_matrix[(column * 4) + row] = static_cast<irr::f32>(p_rotation(row, column));
+			}
+		}
+	}
+}
@@ -0,0 +1,146 @@
+#include "Camera/ResolutionController.h"
+
+namespace Camera
+{
+	ResolutionController::ResolutionController(const std::vector<cv::Size>& p_modes, int p_scale)
+	{
+		m_modes = p_modes;
+		m_mode = 0;
+		m_minScale = std::max(1, p_scale);
+		m_scale = m_minScale;
+		m_budget = 25.0;
+		m_headroom = 0.4;
+		m_average = 0.0;
+		m_overFrames = 0;
+		m_underFrames = 0;
+		m_settleFrames = C_SETTLE_FRAMES;
+		m_stepsDown = 0;
+		m_stepsUp = 0;
+	}
+
+	ResolutionController::~ResolutionController()
+	{
+	}
+
+	bool ResolutionController::Update(double p_milliseconds)
+	{
+		if (m_settleFrames > 0)
+		{
+			// Start averaging over from the frames at the new resolution
+			--m_settleFrames;
+			m_average = p_milliseconds;
+			return false;
+		}
+
+		m_average += ((p_milliseconds - m_average) * 0.1);
+		m_overFrames = ((m_average > m_budget) ? (m_overFrames + 1) : 0);
+		m_underFrames = ((m_average < (m_budget * m_headroom)) ? (m_underFrames + 1) : 0);
+
+		bool changed = false;
+		if (m_overFrames >= C_OVER_FRAMES)
+		{
+			changed = StepDown();
+			m_stepsDown += (changed ? 1 : 0);
+		}
+		else if (m_underFrames >= C_UNDER_FRAMES)
+		{
+			changed = StepUp();
+			m_stepsUp += (changed ? 1 : 0);
+		}
+
+		if (changed)
+		{
+			m_settleFrames = C_SETTLE_FRAMES;
+		}
+		if (changed || m_overFrames >= C_OVER_FRAMES || m_underFrames >= C_UNDER_FRAMES)
+		{
+			m_overFrames = 0;
+			m_underFrames = 0;
+		}
+
+		return changed;
+	}
+
+	void ResolutionController::SetBudget(double p_milliseconds)
+	{
+		m_budget = p_milliseconds;
+	}
+
+	void ResolutionController::SetModes(const std::vector<cv::Size>& p_modes)
+	{
+		m_modes = p_modes;
+		m_mode = 0;
+		m_settleFrames = C_SETTLE_FRAMES;
+	}
+
+	void ResolutionController::SetMinScale(int p_scale)
+	{
+		m_minScale = std::max(1, p_scale);
+		m_scale = std::max(m_scale, m_minScale);
+	}
+
+	int ResolutionController::GetModeCount()
+	{
+		return static_cast<int>(m_modes.size());
+	}
+
+	cv::Size ResolutionController::GetMode()
+	{
+		return (m_modes.empty() ? cv::Size() : m_modes[m_mode]);
+	}
+
+	int ResolutionController::GetScale()
+	{
+		return m_scale;
+	}
+
+	double ResolutionController::GetAverage()
+	{
+		return m_average;
+	}
+
+	unsigned long ResolutionController::GetStepDownCount()
+	{
+		return m_stepsDown;
+	}
+
+	unsigned long ResolutionController::GetStepUpCount()
+	{
+		return m_stepsUp;
+	}
+
+	bool ResolutionController::StepDown()
+	{
+		// A coarser detection scale costs nothing to switch to, the camera mode is the last resort
+		if (m_scale < C_MAX_SCALE)
+		{
+			m_scale = std::min(C_MAX_SCALE, (m_scale * 2));
+			return true;
+		}
+		if ((m_mode + 1) < static_cast<int>(m_modes.size()))
+		{
+			++m_mode;
+			// The frame halved, so the same scale would search a surface half as large
+			m_scale = std::max(m_minScale, (m_scale / 2));
+			return true;
+		}
+		return false;
+	}
+
+	bool ResolutionController::StepUp()
+	{
+		// The size of the camera frame is what the players see, so it comes back first
+		if (m_mode > 0)
+		{
+			--m_mode;
+			m_scale = std::min(C_MAX_SCALE, (m_scale * 2));
+			return true;
+		}
+		if (m_scale > m_minScale)
+		{
+			m_scale = std::max(m_minScale, (m_scale / 2));
+			return true;
+		}
+		return false;
+	}
+}
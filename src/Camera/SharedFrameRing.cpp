@@ -0,0 +1,334 @@
+#include "Camera/SharedFrameRing.h"
+#include <new>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace Camera
+{
+	SharedFrameRing::SharedFrameRing()
+	{
+		m_owner = false;
+		m_memory = NULL;
+		m_size = 0;
+		m_mapping = NULL;
+		m_descriptor = -1;
+		m_header = NULL;
+		m_next = 0;
+		m_oversized = 0;
+	}
+
+	SharedFrameRing::~SharedFrameRing()
+	{
+		Close();
+	}
+
+	bool SharedFrameRing::Create(const std::string& p_name, int p_slotCount, size_t p_imageCapacity)
+	{
+		Close();
+		if (p_name.empty() || p_slotCount <= 0 || p_imageCapacity == 0)
+		{
+			return false;
+		}
+
+		m_name = p_name;
+		m_owner = true;
+		size_t slotSize = (Align(sizeof(Slot)) + Align(p_imageCapacity));
+		if (!Map((Align(sizeof(Header)) + (slotSize * p_slotCount)), true))
+		{
+			std::string message = "SharedFrameRing: Could not create " + p_name;
+			Utility::Logger::GetInstance()->Log(Utility::Logger::LOG_ERROR, message.c_str());
+			Close();
+			return false;
+		}
+
+		m_header = new (m_memory) Header();
+		m_header->m_version = C_VERSION;
+		m_header->m_slotCount = static_cast<unsigned int>(p_slotCount);
+		m_header->m_slotSize = static_cast<unsigned int>(slotSize);
+		m_header->m_imageCapacity = static_cast<unsigned int>(p_imageCapacity);
+		m_header->m_latest.store(C_NO_SLOT);
+		m_header->m_published.store(0);
+		for (unsigned int slot = 0; slot < m_header->m_slotCount; ++slot)
+		{
+			new (GetSlot(slot)) Slot();
+			GetSlot(slot)->m_version.store(0);
+		}
+		m_next = 0;
+
+		// Readers check the magic first, so it is only written once everything else is
+		std::atomic_thread_fence(std::memory_order_release);
+		m_header->m_magic = C_MAGIC;
+		return true;
+	}
+
+	bool SharedFrameRing::Open(const std::string& p_name)
+	{
+		Close();
+		if (p_name.empty())
+		{
+			return false;
+		}
+
+		m_name = p_name;
+		m_owner = false;
+		if (!Map(0, false))
+		{
+			Close();
+			return false;
+		}
+
+		Header* header = reinterpret_cast<Header*>(m_memory);
+		if (m_size < sizeof(Header) || header->m_magic != C_MAGIC || header->m_version != C_VERSION
+				|| m_size < (Align(sizeof(Header)) + (static_cast<size_t>(header->m_slotSize) * header->m_slotCount)))
+		{
+			std::string message = "SharedFrameRing: " + p_name + " is not a frame ring of this version";
+			Utility::Logger::GetInstance()->Log(Utility::Logger::LOG_ERROR, message.c_str());
+			Close();
+			return false;
+		}
+		m_header = header;
+		return true;
+	}
+
+	void SharedFrameRing::Close()
+	{
+#ifdef _WIN32
+		if (m_memory != NULL)
+		{
+			UnmapViewOfFile(m_memory);
+		}
+		if (m_mapping != NULL)
+		{
+			// The mapping is gone once the last process closes it
+			CloseHandle(static_cast<HANDLE>(m_mapping));
+		}
+#else
+		if (m_memory != NULL)
+		{
+			munmap(m_memory, m_size);
+		}
+		if (m_descriptor >= 0)
+		{
+			close(m_descriptor);
+		}
+		if (m_owner && !m_name.empty())
+		{
+			// Readers that still have it mapped keep their view, new readers can no longer open it
+			shm_unlink(((m_name[0] == '/') ? m_name : ("/" + m_name)).c_str());
+		}
+#endif
+		m_owner = false;
+		m_memory = NULL;
+		m_size = 0;
+		m_mapping = NULL;
+		m_descriptor = -1;
+		m_header = NULL;
+		m_name.clear();
+	}
+
+	bool SharedFrameRing::IsOpened()
+	{
+		return (m_header != NULL);
+	}
+
+	bool SharedFrameRing::Publish(const Frame& p_frame)
+	{
+		if (!m_owner || m_header == NULL || p_frame.m_image.empty())
+		{
+			return false;
+		}
+
+		const cv::Mat& image = p_frame.m_image;
+		size_t rowSize = (image.cols * image.elemSize());
+		if ((rowSize * image.rows) > m_header->m_imageCapacity)
+		{
+			++m_oversized;
+			return false;
+		}
+
+		unsigned int index = m_next;
+		m_next = ((m_next + 1) % m_header->m_slotCount);
+		Slot* slot = GetSlot(index);
+
+		// Odd while writing, readers that started before this see the version change and drop what they read
+		unsigned int version = slot->m_version.load(std::memory_order_relaxed);
+		slot->m_version.store((version + 1), std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+
+		FrameInfo& info = slot->m_info;
+		info.m_sequence = (m_header->m_published.load(std::memory_order_relaxed) + 1);
+		info.m_timestamp = p_frame.m_timestamp;
+		info.m_width = image.cols;
+		info.m_height = image.rows;
+		info.m_type = image.type();
+		info.m_step = static_cast<int>(rowSize);
+		info.m_lost = (p_frame.m_lost ? 1 : 0);
+		for (int corner = 0; corner < 4; ++corner)
+		{
+			bool known = (p_frame.m_imageCorners.size() == 4);
+			info.m_corners[(corner * 2)] = (known ? p_frame.m_imageCorners[corner].x : 0.0f);
+			info.m_corners[(corner * 2) + 1] = (known ? p_frame.m_imageCorners[corner].y : 0.0f);
+		}
+		info.m_pixelDistance = p_frame.m_pixelDistance;
+		info.m_lineRatio = p_frame.m_lineRatio;
+		memcpy(info.m_transformation, p_frame.m_transformation.pointer(), sizeof(info.m_transformation));
+
+		unsigned char* pixels = GetImage(index);
+		if (image.isContinuous())
+		{
+			memcpy(pixels, image.data, (rowSize * image.rows));
+		}
+		else
+		{
+			for (int row = 0; row < image.rows; ++row)
+			{
+				memcpy((pixels + (row * rowSize)), image.ptr(row), rowSize);
+			}
+		}
+
+		slot->m_version.store((version + 2), std::memory_order_release);
+		m_header->m_latest.store(index, std::memory_order_release);
+		m_header->m_published.fetch_add(1, std::memory_order_relaxed);
+		return true;
+	}
+
+	int SharedFrameRing::GetLatestSlot()
+	{
+		if (m_header == NULL)
+		{
+			return -1;
+		}
+
+		unsigned int latest = m_header->m_latest.load(std::memory_order_acquire);
+		return ((latest == C_NO_SLOT) ? -1 : static_cast<int>(latest));
+	}
+
+	bool SharedFrameRing::BeginRead(int p_slot, FrameInfo& p_info, cv::Mat& p_image, unsigned int& p_version)
+	{
+		if (m_header == NULL || p_slot < 0 || static_cast<unsigned int>(p_slot) >= m_header->m_slotCount)
+		{
+			return false;
+		}
+
+		Slot* slot = GetSlot(p_slot);
+		p_version = slot->m_version.load(std::memory_order_acquire);
+		if (p_version == 0 || (p_version & 1) != 0)
+		{
+			// Never written, or being written right now
+			return false;
+		}
+
+		p_info = slot->m_info;
+		// A half written size could point past the slot, so it is checked before anything looks at the pixels
+		if (p_info.m_width <= 0 || p_info.m_height <= 0 || p_info.m_step <= 0
+				|| (static_cast<size_t>(p_info.m_step) * p_info.m_height) > m_header->m_imageCapacity)
+		{
+			return false;
+		}
+
+		p_image = cv::Mat(p_info.m_height, p_info.m_width, p_info.m_type, GetImage(p_slot), p_info.m_step);
+		return true;
+	}
+
+	bool SharedFrameRing::EndRead(int p_slot, unsigned int p_version)
+	{
+		std::atomic_thread_fence(std::memory_order_acquire);
+		return (GetSlot(p_slot)->m_version.load(std::memory_order_relaxed) == p_version);
+	}
+
+	unsigned long SharedFrameRing::GetPublishedCount()
+	{
+		return ((m_header != NULL) ? m_header->m_published.load() : 0);
+	}
+
+	unsigned long SharedFrameRing::GetOversizedCount()
+	{
+		return m_oversized;
+	}
+
+	bool SharedFrameRing::Map(size_t p_size, bool p_create)
+	{
+#ifdef _WIN32
+		HANDLE mapping = NULL;
+		if (p_create)
+		{
+			unsigned long long size = p_size;
+			mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE,
+					static_cast<DWORD>(size >> 32), static_cast<DWORD>(size & 0xFFFFFFFF), m_name.c_str());
+		}
+		else
+		{
+			mapping = OpenFileMappingA(FILE_MAP_READ, FALSE, m_name.c_str());
+		}
+		if (mapping == NULL)
+		{
+			return false;
+		}
+		m_mapping = mapping;
+
+		m_memory = static_cast<unsigned char*>(MapViewOfFile(mapping, (p_create ? FILE_MAP_ALL_ACCESS : FILE_MAP_READ), 0, 0, p_size));
+		if (m_memory == NULL)
+		{
+			return false;
+		}
+
+		MEMORY_BASIC_INFORMATION region;
+		VirtualQuery(m_memory, &region, sizeof(region));
+		m_size = (p_create ? p_size : region.RegionSize);
+#else
+		std::string name = ((m_name[0] == '/') ? m_name : ("/" + m_name));
+		if (p_create)
+		{
+			// Left behind by a producer that crashed
+			shm_unlink(name.c_str());
+			m_descriptor = shm_open(name.c_str(), (O_CREAT | O_EXCL | O_RDWR), 0644);
+			if (m_descriptor < 0 || ftruncate(m_descriptor, static_cast<off_t>(p_size)) != 0)
+			{
+				return false;
+			}
+			m_size = p_size;
+		}
+		else
+		{
+			m_descriptor = shm_open(name.c_str(), O_RDONLY, 0);
+			struct stat status;
+			if (m_descriptor < 0 || fstat(m_descriptor, &status) != 0)
+			{
+				return false;
+			}
+			m_size = static_cast<size_t>(status.st_size);
+		}
+
+		void* memory = mmap(NULL, m_size, (p_create ? (PROT_READ | PROT_WRITE) : PROT_READ), MAP_SHARED, m_descriptor, 0);
+		if (memory == MAP_FAILED)
+		{
+			m_size = 0;
+			return false;
+		}
+		m_memory = static_cast<unsigned char*>(memory);
+#endif
+		return true;
+	}
+
+	SharedFrameRing::Slot* SharedFrameRing::GetSlot(unsigned int p_slot)
+	{
+		return reinterpret_cast<Slot*>(m_memory + Align(sizeof(Header)) + (static_cast<size_t>(p_slot) * m_header->m_slotSize));
+	}
+
+	unsigned char* SharedFrameRing::GetImage(unsigned int p_slot)
+	{
+		return (reinterpret_cast<unsigned char*>(GetSlot(p_slot)) + Align(sizeof(Slot)));
+	}
+
+	size_t SharedFrameRing::Align(size_t p_size)
+	{
+		return (((p_size + C_ALIGNMENT) - 1) & ~(C_ALIGNMENT - 1));
+	}
+}
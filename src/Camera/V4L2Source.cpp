@@ -0,0 +1,194 @@
+#include "Camera/V4L2Source.h"
+
+#ifdef __linux__
+
+namespace Camera
+{
+	V4L2Source::V4L2Source(std::string p_device, cv::Size p_size)
+	{
+		m_held = -1;
+		m_bytesPerLine = 0;
+		m_timestamp = 0.0;
+		m_fd = open(p_device.c_str(), O_RDWR);
+		if (m_fd < 0)
+		{
+			LogError("open");
+		}
+		else if (!Open(p_size))
+		{
+			Release();
+		}
+	}
+
+	V4L2Source::~V4L2Source()
+	{
+		Release();
+	}
+
+	bool V4L2Source::Open(cv::Size p_size)
+	{
+		v4l2_format format;
+		memset(&format, 0, sizeof(format));
+		format.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+		format.fmt.pix.width = p_size.width;
+		format.fmt.pix.height = p_size.height;
+		format.fmt.pix.pixelformat = V4L2_PIX_FMT_YUYV;
+		format.fmt.pix.field = V4L2_FIELD_NONE;
+		if (ioctl(m_fd, VIDIOC_S_FMT, &format) < 0 || format.fmt.pix.pixelformat != V4L2_PIX_FMT_YUYV)
+		{
+			LogError("VIDIOC_S_FMT");
+			return false;
+		}
+		// The driver may have picked another size
+		m_size = cv::Size(format.fmt.pix.width, format.fmt.pix.height);
+		m_bytesPerLine = format.fmt.pix.bytesperline;
+
+		v4l2_requestbuffers request;
+		memset(&request, 0, sizeof(request));
+		request.count = 4;
+		request.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+		request.memory = V4L2_MEMORY_MMAP;
+		if (ioctl(m_fd, VIDIOC_REQBUFS, &request) < 0 || request.count < 2)
+		{
+			LogError("VIDIOC_REQBUFS");
+			return false;
+		}
+
+		for (unsigned int i = 0; i < request.count; ++i)
+		{
+			v4l2_buffer buffer;
+			memset(&buffer, 0, sizeof(buffer));
+			buffer.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+			buffer.memory = V4L2_MEMORY_MMAP;
+			buffer.index = i;
+			if (ioctl(m_fd, VIDIOC_QUERYBUF, &buffer) < 0)
+			{
+				LogError("VIDIOC_QUERYBUF");
+				return false;
+			}
+
+			Buffer mapped;
+			mapped.m_length = buffer.length;
+			mapped.m_start = mmap(NULL, buffer.length, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, buffer.m.offset);
+			if (mapped.m_start == MAP_FAILED)
+			{
+				LogError("mmap");
+				return false;
+			}
+			m_buffers.push_back(mapped);
+
+			if (ioctl(m_fd, VIDIOC_QBUF, &buffer) < 0)
+			{
+				LogError("VIDIOC_QBUF");
+				return false;
+			}
+		}
+
+		v4l2_buf_type type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+		if (ioctl(m_fd, VIDIOC_STREAMON, &type) < 0)
+		{
+			LogError("VIDIOC_STREAMON");
+			return false;
+		}
+
+		return true;
+	}
+
+	bool V4L2Source::IsOpened()
+	{
+		return (m_fd >= 0);
+	}
+
+	bool V4L2Source::IsFrameReady()
+	{
+		if (m_fd < 0)
+		{
+			return false;
+		}
+
+		// The driver marks the device readable as soon as a filled buffer can be dequeued
+		pollfd descriptor;
+		descriptor.fd = m_fd;
+		descriptor.events = POLLIN;
+		descriptor.revents = 0;
+		return (poll(&descriptor, 1, 0) > 0 && (descriptor.revents & POLLIN) != 0);
+	}
+
+	cv::Size V4L2Source::GetSize()
+	{
+		return m_size;
+	}
+
+	bool V4L2Source::Read(cv::Mat& p_image)
+	{
+		if (m_fd < 0)
+		{
+			return false;
+		}
+
+		v4l2_buffer buffer;
+		if (m_held >= 0)
+		{
+			// The previous frame has been converted, so the driver may fill its buffer again
+			memset(&buffer, 0, sizeof(buffer));
+			buffer.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+			buffer.memory = V4L2_MEMORY_MMAP;
+			buffer.index = m_held;
+			ioctl(m_fd, VIDIOC_QBUF, &buffer);
+			m_held = -1;
+		}
+
+		memset(&buffer, 0, sizeof(buffer));
+		buffer.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+		buffer.memory = V4L2_MEMORY_MMAP;
+		while (ioctl(m_fd, VIDIOC_DQBUF, &buffer) < 0)
+		{
+			if (errno != EINTR)
+			{
+				LogError("VIDIOC_DQBUF");
+				p_image.release();
+				return false;
+			}
+		}
+		m_held = buffer.index;
+		m_timestamp = ((buffer.timestamp.tv_sec * 1000.0) + (buffer.timestamp.tv_usec / 1000.0));
+
+		// Wrap the mapped buffer without copying it and convert straight into the frame
+		cv::Mat yuyv = cv::Mat(m_size, CV_8UC2, m_buffers[buffer.index].m_start, m_bytesPerLine);
+		cv::cvtColor(yuyv, p_image, CV_YUV2BGR_YUYV);
+		return true;
+	}
+
+	double V4L2Source::GetTimestamp()
+	{
+		return m_timestamp;
+	}
+
+	void V4L2Source::Release()
+	{
+		if (m_fd < 0)
+		{
+			return;
+		}
+
+		v4l2_buf_type type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+		ioctl(m_fd, VIDIOC_STREAMOFF, &type);
+		for (unsigned int i = 0; i < m_buffers.size(); ++i)
+		{
+			munmap(m_buffers[i].m_start, m_buffers[i].m_length);
+		}
+		m_buffers.clear();
+		m_held = -1;
+
+		close(m_fd);
+		m_fd = -1;
+	}
+
+	void V4L2Source::LogError(const char* p_call)
+	{
+		std::string message = std::string("V4L2Source: ") + p_call + " failed: " + strerror(errno);
+		Utility::Logger::GetInstance()->Log(Utility::Logger::LOG_ERROR, message.c_str());
+	}
+}
+
+#endif
@@ -0,0 +1,111 @@
+#include "Camera/VideoSource.h"
+
+namespace Camera
+{
+	VideoSource::VideoSource(std::string p_fileName)
+	{
+		m_fileName = p_fileName;
+		m_capture = cv::VideoCapture(m_fileName);
+		m_size = cv::Size(
+				static_cast<int>(m_capture.get(CV_CAP_PROP_FRAME_WIDTH)),
+				static_cast<int>(m_capture.get(CV_CAP_PROP_FRAME_HEIGHT)));
+		m_fps = m_capture.get(CV_CAP_PROP_FPS);
+		if (m_fps <= 0.0)
+		{
+			// Image sequences have no frame rate, assume a regular webcam
+			m_fps = 30.0;
+		}
+		m_loop = true;
+		m_paced = false;
+		m_frameCount = 0;
+		m_timestamp = 0.0;
+		m_start = std::chrono::steady_clock::now();
+	}
+
+	VideoSource::~VideoSource()
+	{
+		Release();
+	}
+
+	bool VideoSource::IsOpened()
+	{
+		return m_capture.isOpened();
+	}
+
+	cv::Size VideoSource::GetSize()
+	{
+		return m_size;
+	}
+
+	bool VideoSource::IsFrameReady()
+	{
+		if (!m_capture.isOpened())
+		{
+			return false;
+		}
+		if (!m_paced)
+		{
+			return true;
+		}
+
+		long long due = static_cast<long long>((m_frameCount * 1000.0) / m_fps);
+		return (std::chrono::steady_clock::now() >= (m_start + std::chrono::milliseconds(due)));
+	}
+
+	bool VideoSource::Read(cv::Mat& p_image)
+	{
+		if (!m_capture.read(p_image) && m_loop && m_frameCount > 0)
+		{
+			// Open the recording again, seeking does not work for every codec or for image sequences
+			m_capture.release();
+			m_capture.open(m_fileName);
+			m_capture.read(p_image);
+		}
+
+		if (p_image.empty())
+		{
+			return false;
+		}
+
+		m_timestamp = ((m_frameCount * 1000.0) / m_fps);
+		++m_frameCount;
+
+		if (m_paced)
+		{
+			std::this_thread::sleep_until(m_start + std::chrono::milliseconds(static_cast<long long>(m_timestamp)));
+		}
+
+		return true;
+	}
+
+	double VideoSource::GetTimestamp()
+	{
+		return m_timestamp;
+	}
+
+	void VideoSource::Release()
+	{
+		m_capture.release();
+	}
+
+	void VideoSource::SetLoop(bool p_loop)
+	{
+		m_loop = p_loop;
+	}
+
+	void VideoSource::SetPaced(bool p_paced)
+	{
+		m_paced = p_paced;
+		m_start = (std::chrono::steady_clock::now() - std::chrono::milliseconds(static_cast<long long>(m_timestamp)));
+	}
+
+	void VideoSource::SetFps(double p_fps)
+	{
+		m_fps = p_fps;
+	}
+
+	unsigned long VideoSource::GetFrameCount()
+	{
+		return m_frameCount;
+	}
+}
@@ -109,7 +109,20 @@ namespace Game
 					m_device->getSceneManager()->getActiveCamera()->setInputReceiverEnabled(true);
 				}
 				return true;
-			}			
+			}
+			if (keyInput == irr::KEY_KEY_P && !p_event.KeyInput.PressedDown)
+			{
+				//Shows/hides the capture latencies
+				if (m_gui->IsProfilerOverlayVisible())
+				{
+					m_gui->HideProfilerOverlay();
+				}
+				else
+				{
+					m_gui->ShowProfilerOverlay();
+				}
+				return true;
+			}
 		}
 		else if (p_event.EventType == irr::EET_MOUSE_INPUT_EVENT)
 		{
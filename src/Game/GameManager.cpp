@@ -86,7 +86,8 @@ namespace Game
 
 	void GameManager::SetupCamera()
 	{
-		// Create a static camera
+		// Create a static camera. The pose of the playground comes from the calibrated camera matrix,
+		// so the scene only lines up with the camera image when this projection matches those intrinsics.
 		m_camera = m_sceneManager->addCameraSceneNode(NULL,
 				irr::core::vector3df(0.0f, 0.0f, 0.0f),
 				irr::core::vector3df(0.0f, 0.0f, 1.0f));
@@ -105,9 +106,11 @@ namespace Game
 		return m_eventHandler;
 	}
 
-	irr::video::ITexture* GameManager::GetCameraTexture()
+	irr::video::ITexture* GameManager::GetCameraTexture(irr::core::dimension2du p_size, int p_index)
 	{
-		return m_videoDriver->addTexture(irr::core::dimension2d<irr::u32>(640, 480), "capture_background");
+		irr::core::stringc name = "capture_background_";
+		name += p_index;
+		return m_videoDriver->addTexture(p_size, name, irr::video::ECF_A8R8G8B8);
 	}
 
 	void GameManager::SetCameraHeight(float p_cameraHeight)
@@ -130,13 +133,60 @@ namespace Game
 		return m_sceneManager->getSceneNodeFromId(C_EMPTY_ROOT_SCENENODE);
 	}
 
-	void GameManager::DrawCameraTexture()
+	void GameManager::DrawCameraTexture(irr::video::ITexture* p_texture)
 	{
-		m_videoDriver->draw2DImage(m_videoDriver->getTexture("capture_background"),
+		if (p_texture == NULL)
+		{
+			return;
+		}
+
+		m_videoDriver->draw2DImage(p_texture,
 				irr::core::recti(0, 0, m_resolution.Width, m_resolution.Height),
 				irr::core::recti(0, 0, m_captureResolution.Width, m_captureResolution.Height));
 	}
 
+	void GameManager::DrawDebugOverlay(const std::vector<Camera::DebugOverlay::Primitive>& p_primitives)
+	{
+		// The camera image covers the whole screen
+		float width = static_cast<float>(m_resolution.Width);
+		float height = static_cast<float>(m_resolution.Height);
+		irr::gui::IGUIFont* font = m_device->getGUIEnvironment()->getBuiltInFont();
+		for (size_t i = 0; i < p_primitives.size(); ++i)
+		{
+			const Camera::DebugOverlay::Primitive& primitive = p_primitives[i];
+			irr::video::SColor color = irr::video::SColor(255, primitive.m_red, primitive.m_green, primitive.m_blue);
+			irr::core::position2di start = irr::core::position2di(
+					static_cast<irr::s32>(primitive.m_x1 * width), static_cast<irr::s32>(primitive.m_y1 * height));
+			irr::core::position2di end = irr::core::position2di(
+					static_cast<irr::s32>(primitive.m_x2 * width), static_cast<irr::s32>(primitive.m_y2 * height));
+			switch (primitive.m_type)
+			{
+			case Camera::DebugOverlay::TYPE_POINT:
+				{
+					irr::s32 radius = std::max(1, static_cast<irr::s32>(primitive.m_radius * width));
+					m_videoDriver->draw2DRectangleOutline(irr::core::recti((start.X - radius), (start.Y - radius), (start.X + radius), (start.Y + radius)), color);
+				}
+				break;
+			case Camera::DebugOverlay::TYPE_LINE:
+				m_videoDriver->draw2DLine(start, end, color);
+				break;
+			case Camera::DebugOverlay::TYPE_RECTANGLE:
+				m_videoDriver->draw2DRectangleOutline(irr::core::recti(start, end), color);
+				break;
+			case Camera::DebugOverlay::TYPE_LABEL:
+				if (font != NULL)
+				{
+					irr::core::stringw text = primitive.m_label;
+					irr::core::dimension2du size = font->getDimension(text.c_str());
+					font->draw(text, irr::core::recti(start.X, (start.Y - size.Height), (start.X + size.Width), start.Y), color);
+				}
+				break;
+			default:
+				break;
+			}
+		}
+	}
+
 	irr::core::matrix4 GameManager::GetCameraProjectionMatrix()
 	{
 		return m_camera->getProjectionMatrix();
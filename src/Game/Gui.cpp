@@ -13,6 +13,8 @@ namespace Game
 		m_textFps = NULL;
 		m_textPlayer1Points = NULL;
 		m_textPlayer2Points = NULL;
+		m_textProfiler = NULL;
+		m_profilerUpdateCount = 0;
 	 	m_buttonAttackersTurn = NULL;
 		m_buttonBuyPencil = NULL;
 		m_buttonCapturePencils = NULL;
@@ -68,6 +70,13 @@ namespace Game
 		m_textPlayer1Points->setText(StringToWString("Player 1 Points : ", p_player1Points).c_str());
 		m_textPlayer2Points->setText(StringToWString("Player 2 Points : ", p_player2Points).c_str());
 
+		// Refresh the profiler overlay a few times per second, building the summary is not free
+		if (m_textProfiler != NULL && (m_profilerUpdateCount++ % 30) == 0)
+		{
+			std::string summary = Utility::Profiler::GetInstance()->GetSummary();
+			m_textProfiler->setText(std::wstring(summary.begin(), summary.end()).c_str());
+		}
+
 		m_guiEnvironment->drawAll();
 	}
 
@@ -128,6 +137,35 @@ namespace Game
 	}
 
 
+	void Gui::ShowProfilerOverlay()
+	{
+		if (m_textProfiler == NULL)
+		{
+			// Showing the overlay also starts measuring
+			Utility::Profiler::GetInstance()->SetEnabled(true);
+
+			m_textProfiler = m_guiEnvironment->addStaticText(L" ", irr::core::recti(10, 10, 610, 210), false, true, NULL, -1, true);
+			m_textProfiler->setOverrideFont(m_guiEnvironment->getBuiltInFont());
+			m_textProfiler->setOverrideColor(irr::video::SColor(255, 255, 255, 255));
+			m_textProfiler->setBackgroundColor(irr::video::SColor(160, 0, 0, 0));
+			m_profilerUpdateCount = 0;
+		}
+	}
+
+	void Gui::HideProfilerOverlay()
+	{
+		if (m_textProfiler != NULL)
+		{
+			m_textProfiler->remove();
+			m_textProfiler = NULL;
+		}
+	}
+
+	bool Gui::IsProfilerOverlayVisible()
+	{
+		return (m_textProfiler != NULL);
+	}
+
 	void Gui::ShowVictory(PlayerType p_playerType)
 	{
 		if (m_imageVictory == NULL)
@@ -5,6 +5,9 @@ namespace Game
 	Kernel::Kernel()
 	{
 		m_resolution = irr::core::dimension2du(1280, 960);
+		m_undistortPoints = false;
+		m_frameSource = "camera";
+		m_sharedOutput = "";
 		m_device = irr::createDevice(irr::video::EDT_DIRECT3D9, m_resolution);
 
 		if (!m_device)
@@ -52,26 +55,58 @@ namespace Game
 		// Gets the root scene node
 		irr::scene::ISceneNode* root = m_gameManager->GetRootSceneNode();
 		//// Capture class
-		Camera::Capture* capture = new Camera::Capture(m_multiThreaded, m_resolution, m_gameManager->GetCameraTexture());
+		Camera::FrameSource* frameSource = Camera::FrameSource::Create(m_frameSource);
+		if (!frameSource->IsOpened())
+		{
+			std::string message = "Kernel: Could not open frame source " + m_frameSource;
+			Utility::Logger::GetInstance()->Log(Utility::Logger::LOG_ERROR, message.c_str());
+		}
+		// Two textures of the camera size, one is written while the other one is drawn
+		cv::Size captureSize = frameSource->GetSize();
+		irr::core::dimension2du textureSize = irr::core::dimension2du(captureSize.width, captureSize.height);
+		Camera::Capture* capture = new Camera::Capture(m_multiThreaded, m_resolution,
+				m_gameManager->GetCameraTexture(textureSize, 0), m_gameManager->GetCameraTexture(textureSize, 1), frameSource);
 		m_inputHandler->AddListener(capture);
 		capture->SetFov(60);
+		if (!m_sharedOutput.empty())
+		{
+			// Four frames give a reader that is a little late a chance to finish
+			capture->SetSharedOutput(m_sharedOutput, 4);
+		}
+		capture->SetUndistortMode(m_undistortPoints
+				? Camera::Capture::UNDISTORT_POINTS
+				: Camera::Capture::UNDISTORT_FRAME);
 		capture->SetShortestGameLine(irr::core::line2df(
 			irr::core::vector2df(0.0f, 0.0f),
 			irr::core::vector2df(0.0f, m_gameManager->GetGameHeight())));
 		
 		// Sets the resolution of the camera for the scaling of the background
 		m_gameManager->SetCaptureResolution(capture->GetCaptureSize());
+
+		// From camera frame to screen, measured when a frame with a pose has been presented
+		Utility::LatencyHistogram* motionToPhoton = Utility::Profiler::GetInstance()->GetHistogram("render.motion_to_photon");
+		// How long a render frame takes from its start until it is presented, smoothed
+		long long displayLatency = 0;
+		// Created here, before the capture threads start and ask for it at the same time as the render thread
+		Camera::DebugOverlay* overlay = Camera::DebugOverlay::GetInstance();
+		// Only hands the pencils to the game once they lie still and differ from what it got before
+		Camera::PencilTracker pencilTracker;
 		
 		while (m_device->run())
 		{
+			long long frameStart = Utility::Profiler::GetTicks();
+			bool posed = false;
+
 			capture->Start();
+			// Take the newest camera frame without waiting for the capture thread
+			capture->AcquireFrame();
 			m_gameManager->SetCameraHeight(capture->GetPixelDistance());
 			m_gameManager->SetGameLength(capture->GetCalculatedLongestGameLine().getLength());
 
 			// Begin the scene
 			m_gameManager->BeginScene();
 			// Always draw the camera background
-			m_gameManager->DrawCameraTexture();
+			m_gameManager->DrawCameraTexture(capture->GetTexture());
 			
 			if (capture->HasChosen())
 			{
@@ -82,11 +117,12 @@ namespace Game
 						m_inputHandler->RemoveListener(capture);
 					}
 
-					// Gets the transformation matrix and sets it on the root matrix
-					irr::core::matrix4 transformation = capture->GetTransformMatrix(m_gameManager->GetCameraProjectionMatrix());
+					// Gets the transformation matrix where the playground will be when this frame is shown
+					irr::core::matrix4 transformation = capture->GetPredictedTransformMatrix(frameStart + displayLatency);
 					root->setPosition(transformation.getTranslation());
 					root->setRotation(transformation.getRotationDegrees());
 					root->setScale(transformation.getScale());
+					posed = true;
 
 				}
 				if (m_gameManager->IsLookingForPencilCoords())
@@ -94,22 +130,69 @@ namespace Game
 					irr::core::vector3df* startPoints = NULL;
 					irr::core::vector3df* endPoints = NULL;
 					int pencilCount = capture->FindStartAndEndPoints(capture->GetImage(), m_gameManager->GetCameraProjectionMatrix(), startPoints, endPoints);
-
-					if (pencilCount > 0)
-					{
-						m_gameManager->SetPencilCoords(startPoints, endPoints, pencilCount);
-					}
+					bool changed = pencilTracker.Update(startPoints, endPoints, pencilCount, capture->GetSequence());
 
 					delete[] startPoints;
 					delete[] endPoints;
+
+					// The path is only built again when the layout really changed
+					if (changed)
+					{
+						startPoints = NULL;
+						endPoints = NULL;
+						pencilCount = pencilTracker.GetLayout(startPoints, endPoints);
+						if (pencilCount > 0)
+						{
+							m_gameManager->SetPencilCoords(startPoints, endPoints, pencilCount);
+						}
+
+						delete[] startPoints;
+						delete[] endPoints;
+					}
+				}
+				else
+				{
+					// The next time the pencils are captured the layout is handed over again, even when it is the same
+					pencilTracker.Reset();
 				}
 
 				// Actually draw the scene, but only once the playground surface has been chosen
 				m_gameManager->GameTick();
 			
 			}
+
+			// The detectors only leave their debug output in the overlay, it is shown from here
+			if (overlay->IsEnabled())
+			{
+				bool changed = overlay->Update();
+				if (overlay->GetOutput() == Camera::DebugOverlay::OUTPUT_GUI)
+				{
+					m_gameManager->DrawDebugOverlay(overlay->GetPrimitives());
+				}
+				else
+				{
+					overlay->Show(capture->GetImage(), changed);
+				}
+			}
+
 			// End the scene
 			m_gameManager->EndScene();
+
+			// EndScene returns once the frame is handed to the display, which is as close to the screen as we can measure
+			long long presented = Utility::Profiler::GetTicks();
+			displayLatency += (((presented - frameStart) - displayLatency) / 8);
+			if (posed && Utility::Profiler::GetInstance()->IsEnabled())
+			{
+				motionToPhoton->Record(Utility::Profiler::TicksToMicroseconds(presented - capture->GetAcquiredTicks()));
+			}
+
+			// Logs the latencies of the capture stages when the dump interval has passed
+			Utility::Profiler::GetInstance()->Update();
+		}
+
+		if (Utility::Profiler::GetInstance()->IsEnabled())
+		{
+			Utility::Profiler::GetInstance()->LogSummary();
 		}
 
 		// Cleanup the capture
@@ -120,4 +203,19 @@ namespace Game
 	{
 		m_multiThreaded = p_multiThreaded;
 	}
+
+	void Kernel::SetUndistortPoints(bool p_undistortPoints)
+	{
+		m_undistortPoints = p_undistortPoints;
+	}
+
+	void Kernel::SetFrameSource(std::string p_frameSource)
+	{
+		m_frameSource = p_frameSource;
+	}
+
+	void Kernel::SetSharedOutput(std::string p_sharedOutput)
+	{
+		m_sharedOutput = p_sharedOutput;
+	}
 }
\ No newline at end of file
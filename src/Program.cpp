@@ -1,4 +1,6 @@
 #include "Utility/Logger.h"
+#include "Utility/Profiler.h"
+#include "Camera/DebugOverlay.h"
 #include "Game/kernel.h"
 
 int main (int argc, char* argv[])
@@ -11,13 +13,67 @@ int main (int argc, char* argv[])
 	if (true)
 	{
 		Game::Kernel* kernel = new Game::Kernel();
-		if (argc > 1)
+		kernel->SetMultiThreaded(true);
+		for (int i = 1; i < argc; ++i)
 		{
-			kernel->SetMultiThreaded(false);
-		}
-		else
-		{
-			kernel->SetMultiThreaded(true);
+			std::string argument = argv[i];
+			if ((argument == "--video" || argument == "--source") && (i + 1) < argc)
+			{
+				// A video file, an image sequence, camera:<id> or v4l2:<device>
+				kernel->SetFrameSource(argv[++i]);
+			}
+			else if (argument == "--share" && (i + 1) < argc)
+			{
+				// Publishes the frames and the pose in shared memory under this name
+				kernel->SetSharedOutput(argv[++i]);
+			}
+			else if (argument == "--undistort-points")
+			{
+				kernel->SetUndistortPoints(true);
+			}
+			else if (argument == "--profile")
+			{
+				// Optionally followed by the number of seconds between two logged summaries
+				double interval = 10.0;
+				if ((i + 1) < argc && atof(argv[i + 1]) > 0.0)
+				{
+					interval = atof(argv[++i]);
+				}
+				Utility::Profiler::GetInstance()->SetEnabled(true);
+				Utility::Profiler::GetInstance()->SetDumpInterval(interval);
+			}
+			else if (argument == "--debug-overlay" && (i + 1) < argc)
+			{
+				// window, gui, or disk optionally followed by the directory to write the images to
+				std::string output = argv[++i];
+				Camera::DebugOverlay* overlay = Camera::DebugOverlay::GetInstance();
+				if (output == "window")
+				{
+					overlay->SetOutput(Camera::DebugOverlay::OUTPUT_WINDOW);
+				}
+				else if (output == "gui")
+				{
+					overlay->SetOutput(Camera::DebugOverlay::OUTPUT_GUI);
+				}
+				else if (output == "disk")
+				{
+					overlay->SetOutput(Camera::DebugOverlay::OUTPUT_DISK);
+					if ((i + 1) < argc && argv[i + 1][0] != '-')
+					{
+						overlay->SetDirectory(argv[++i]);
+					}
+				}
+				else
+				{
+					std::string message = "Main: Unknown debug overlay output " + output + ", use window, gui or disk";
+					logger->Log(Utility::Logger::LOG_ERROR, message.c_str());
+				}
+			}
+			else
+			{
+				// Any other argument keeps the old meaning of running single threaded
+				kernel->SetMultiThreaded(false);
+			}
 		}
 		kernel->Start();
 		delete kernel;
@@ -30,6 +86,8 @@ int main (int argc, char* argv[])
 	}
 
 	logger->Log(Utility::Logger::LOG_MESSAGE, "Main: Game stopped");
+	Camera::DebugOverlay::ResetInstance();
+	Utility::Profiler::ResetInstance();
 	Utility::Logger::ResetInstance();
 
 	return 0;
@@ -0,0 +1,117 @@
+#include "../../include/Utility/LatencyHistogram.h"
+
+Utility::LatencyHistogram::LatencyHistogram()
+{
+	Reset();
+}
+
+void Utility::LatencyHistogram::Record(long long p_microseconds)
+{
+	if (p_microseconds < 0)
+	{
+		p_microseconds = 0;
+	}
+	else if (p_microseconds > 0xFFFFFFFFLL)
+	{
+		p_microseconds = 0xFFFFFFFFLL;
+	}
+
+	++m_buckets[GetBucket(static_cast<unsigned int>(p_microseconds))];
+	++m_count;
+	m_sum += p_microseconds;
+
+	long long max = m_max.load();
+	while (p_microseconds > max && !m_max.compare_exchange_weak(max, p_microseconds))
+	{
+	}
+}
+
+void Utility::LatencyHistogram::Reset()
+{
+	for (int i = 0; i < C_BUCKET_COUNT; ++i)
+	{
+		m_buckets[i] = 0;
+	}
+	m_count = 0;
+	m_sum = 0;
+	m_max = 0;
+}
+
+unsigned long long Utility::LatencyHistogram::GetCount()
+{
+	return m_count;
+}
+
+double Utility::LatencyHistogram::GetMean()
+{
+	unsigned long long count = m_count;
+	return ((count > 0) ? (static_cast<double>(m_sum) / count) : 0.0);
+}
+
+long long Utility::LatencyHistogram::GetMax()
+{
+	return m_max;
+}
+
+long long Utility::LatencyHistogram::GetPercentile(double p_percentile)
+{
+	unsigned long long count = m_count;
+	if (count == 0)
+	{
+		return 0;
+	}
+
+	// The number of latencies at or below the percentile, at least one
+	unsigned long long target = static_cast<unsigned long long>((p_percentile / 100.0) * count + 0.5);
+	if (target < 1)
+	{
+		target = 1;
+	}
+
+	unsigned long long seen = 0;
+	for (int i = 0; i < C_BUCKET_COUNT; ++i)
+	{
+		seen += m_buckets[i];
+		if (seen >= target)
+		{
+			// Never report more than was actually recorded
+			long long bucketMax = GetBucketMax(i);
+			long long max = m_max;
+			return ((bucketMax < max) ? bucketMax : max);
+		}
+	}
+
+	return m_max;
+}
+
+int Utility::LatencyHistogram::GetBucket(unsigned int p_microseconds)
+{
+	// The first two powers of two are stored exactly
+	if (p_microseconds < (2 * C_SUB_BUCKET_COUNT))
+	{
+		return static_cast<int>(p_microseconds);
+	}
+
+	unsigned long highestBit;
+#ifdef _MSC_VER
+	_BitScanReverse(&highestBit, p_microseconds);
+#else
+	highestBit = (31 - __builtin_clz(p_microseconds));
+#endif
+
+	int shift = (static_cast<int>(highestBit) - C_SUB_BUCKET_BITS);
+	int subBucket = static_cast<int>(p_microseconds >> shift);
+	return ((shift * C_SUB_BUCKET_COUNT) + subBucket);
+}
+
+long long Utility::LatencyHistogram::GetBucketMax(int p_bucket)
+{
+	if (p_bucket < (2 * C_SUB_BUCKET_COUNT))
+	{
+		return p_bucket;
+	}
+
+	int shift = ((p_bucket / C_SUB_BUCKET_COUNT) - 1);
+	long long subBucket = ((p_bucket % C_SUB_BUCKET_COUNT) + C_SUB_BUCKET_COUNT);
+	return (((subBucket + 1) << shift) - 1);
+}
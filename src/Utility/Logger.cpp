@@ -45,7 +45,11 @@ void Utility::Logger::OpenLogFile()
 {
 	if (m_fileToWrite == NULL)
 	{
+#ifdef _WIN32
 		_mkdir("Log");
+#else
+		mkdir("Log", 0755);
+#endif
 		m_fileToWrite = new std::ofstream(m_logFilename, std::ofstream::app);
 	}
 }
@@ -0,0 +1,26 @@
+#include "../../include/Utility/ProfileScope.h"
+
+Utility::ProfileScope::ProfileScope(LatencyHistogram* const p_histogram)
+{
+	m_histogram = NULL;
+	m_start = 0;
+
+	if (p_histogram != NULL && Profiler::GetInstance()->IsEnabled())
+	{
+		m_histogram = p_histogram;
+		m_start = Profiler::GetTicks();
+	}
+}
+
+Utility::ProfileScope::~ProfileScope()
+{
+	if (m_histogram != NULL)
+	{
+		m_histogram->Record(Profiler::TicksToMicroseconds(Profiler::GetTicks() - m_start));
+	}
+}
+
+void Utility::ProfileScope::Discard()
+{
+	m_histogram = NULL;
+}
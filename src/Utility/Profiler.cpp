@@ -0,0 +1,129 @@
+#include "../../include/Utility/Profiler.h"
+#include <opencv/cv.h>
+
+Utility::Profiler* Utility::Profiler::m_profiler = NULL;
+
+Utility::Profiler::Profiler()
+{
+	m_enabled = false;
+	m_dumpIntervalTicks = 0;
+	m_lastDumpTicks = GetTicks();
+}
+
+Utility::Profiler::~Profiler()
+{
+	std::map<std::string, LatencyHistogram*>::iterator it;
+	for (it = m_histograms.begin(); it != m_histograms.end(); ++it)
+	{
+		delete it->second;
+	}
+	m_histograms.clear();
+}
+
+Utility::Profiler* Utility::Profiler::GetInstance()
+{
+	if (m_profiler == NULL)
+	{
+		m_profiler = new Utility::Profiler();
+	}
+
+	return m_profiler;
+}
+
+void Utility::Profiler::ResetInstance()
+{
+	delete m_profiler;
+	m_profiler = NULL;
+}
+
+Utility::LatencyHistogram* Utility::Profiler::GetHistogram(const std::string& p_name)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	LatencyHistogram*& histogram = m_histograms[p_name];
+	if (histogram == NULL)
+	{
+		histogram = new LatencyHistogram();
+	}
+
+	return histogram;
+}
+
+void Utility::Profiler::SetEnabled(const bool p_state)
+{
+	m_enabled = p_state;
+}
+
+bool Utility::Profiler::IsEnabled()
+{
+	return m_enabled;
+}
+
+void Utility::Profiler::SetDumpInterval(const double p_seconds)
+{
+	m_dumpIntervalTicks = static_cast<long long>(p_seconds * cv::getTickFrequency());
+	m_lastDumpTicks = GetTicks();
+}
+
+void Utility::Profiler::Update()
+{
+	if (!m_enabled || m_dumpIntervalTicks <= 0)
+	{
+		return;
+	}
+
+	long long now = GetTicks();
+	if ((now - m_lastDumpTicks) >= m_dumpIntervalTicks)
+	{
+		m_lastDumpTicks = now;
+		LogSummary();
+	}
+}
+
+std::string Utility::Profiler::GetSummary()
+{
+	std::stringstream summary;
+	summary << std::fixed << std::setprecision(2);
+	summary << "stage                count     mean      p50      p90      p99      max (ms)";
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	std::map<std::string, LatencyHistogram*>::iterator it;
+	for (it = m_histograms.begin(); it != m_histograms.end(); ++it)
+	{
+		LatencyHistogram* histogram = it->second;
+		summary << std::endl << std::left << std::setw(18) << it->first << std::right
+				<< std::setw(8) << histogram->GetCount()
+				<< std::setw(9) << (histogram->GetMean() / 1000.0)
+				<< std::setw(9) << (histogram->GetPercentile(50.0) / 1000.0)
+				<< std::setw(9) << (histogram->GetPercentile(90.0) / 1000.0)
+				<< std::setw(9) << (histogram->GetPercentile(99.0) / 1000.0)
+				<< std::setw(9) << (histogram->GetMax() / 1000.0);
+	}
+
+	return summary.str();
+}
+
+void Utility::Profiler::LogSummary()
+{
+	std::string summary = "Profiler:\n" + GetSummary();
+	Logger::GetInstance()->Log(Logger::LOG_MESSAGE, summary.c_str());
+}
+
+void Utility::Profiler::ResetHistograms()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	std::map<std::string, LatencyHistogram*>::iterator it;
+	for (it = m_histograms.begin(); it != m_histograms.end(); ++it)
+	{
+		it->second->Reset();
+	}
+}
+
+long long Utility::Profiler::GetTicks()
+{
+	return cv::getTickCount();
+}
+
+long long Utility::Profiler::TicksToMicroseconds(const long long p_ticks)
+{
+	return static_cast<long long>((p_ticks * 1000000.0) / cv::getTickFrequency());
+}